@@ -57,6 +57,14 @@ FaceTools_EXPORT void updateRenderers( const FMS&);
 // Return a colour giving best contrast with the parameter colour.
 FaceTools_EXPORT QColor chooseContrasting( const QColor&);
 
+// Call fn(i) for every i in [0,n) with the range split into contiguous blocks run concurrently
+// on a persistent pool of (hardware concurrency) threads with the calling thread also running
+// blocks. Blocks until all calls are done. Safe to call from within fn or other pool threads.
+// Ranges of fewer than two blocks of minBlock are run in the calling thread. Use a small
+// minBlock when each call is expensive. fn must be safe to call concurrently for
+// different values of i (i.e. only read shared data and write to index i).
+FaceTools_EXPORT void parallelFor( size_t n, const std::function<void( size_t)> &fn, size_t minBlock=512);
+
 }   // end namespace
 
 #endif
@@ -19,6 +19,7 @@
 #define FACE_TOOLS_ACTION_ACTION_UPDATE_MEASUREMENTS_H
 
 #include "FaceAction.h"
+#include <QMutex>
 
 namespace FaceTools { namespace Action {
 
@@ -28,12 +29,38 @@ public:
     ActionUpdateMeasurements();
 
     static bool updateMeasurement( FM*, int mid);
+    // Update all metrics for the given model, calculating them concurrently.
     static bool updateAllMeasurements( FM*);
 
+    // Update only the metrics that depend on the given landmarks returning
+    // the ids of the metrics that were successfully (re)measured.
+    static IntSet updateMeasurementsForLandmarks( FM*, const IntSet &lmids);
+
+    // Record that the given landmark was moved on the given model by the given action so that
+    // the next triggered update need only re-evaluate the metrics that depend upon it. The action
+    // must then raise Event::LANDMARKS_CHANGE itself. Any LANDMARKS_CHANGE raised for the model
+    // that isn't preceded by a record from its raising action causes all metrics to be updated.
+    static void addChangedLandmark( const FaceAction*, const FM*, int lmid);
+
+    // Returns true iff an update on the given model since the last call was partial in which case
+    // mids is set to the ids of the metrics that were updated. The ids are consumed by the call.
+    static bool lastUpdated( const FM*, IntSet &mids);
+
 protected:
+    void postInit() override;
+    void purge( const FM*) override;
     bool doBeforeAction( Event) override;
     void doAction( Event) override;
     Event doAfterAction( Event) override;
+
+private:
+    static QMutex _mutex;
+    static IntSet _updateMeasurements( FM*, const IntSet&);
+    static void _noteRaised( const FM*, Event, const FaceAction*);
+    static std::unordered_map<const FM*, IntSet> _changedLmks;  // Pending changed landmarks
+    static std::unordered_map<const FM*, std::unordered_set<const FaceAction*> > _recorders;   // Actions having recorded changes
+    static std::unordered_set<const FM*> _unrecorded;   // Models with landmark changes not recorded
+    static std::unordered_map<const FM*, IntSet> _updatedMids;  // Metrics updated in partial updates not yet consumed
 };  // end class
 
 }}   // end namespaces
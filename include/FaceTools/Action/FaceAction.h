@@ -23,6 +23,7 @@
 #include "FaceActionWorker.h"
 #include <QTools/PluginInterface.h>
 #include <QAction>
+#include <cassert>
 
 namespace FaceTools { namespace Action {
 
@@ -168,11 +169,17 @@ public slots:
     void refresh( Event e=Event::NONE);
 
     /**
-     * For asynchronous actions, this function is called if the action times out.
-     * The action should stop what it's doing and finish immediately.
+     * Request that the action's current work stops early. By default, this cancels the action's
+     * TaskState which long running work checks cooperatively (see TaskState). The action still
+     * finishes through doAfterAction where isCancelled() will return true.
      */
     virtual void endNow();
 
+    /**
+     * Fraction of the action's current work done or zero if not running or not reported.
+     */
+    float progress() const { return _task ? _task->progress() : 0.0f;}
+
 protected:
     /**
      * Called on self at the end of _init(). Override to manually adjust details of action/icon assignment here.
@@ -186,12 +193,29 @@ protected:
     void setAsync( bool async);
     bool isAsync() const { return _doasync;}
 
+    /**
+     * Make this action's asynchronous work on a model wait until all earlier scheduled work on the
+     * same model by actions of type A has finished (see FaceActionWorker). Work by independent actions
+     * and on other models runs concurrently. Call from the constructor of the derived action.
+     * FaceActionManager::finalise orders actions after their dependencies so that dependencies
+     * triggered by the same event(s) are scheduled first. Work by A scheduled only after this
+     * action's work (e.g. by a later event) is not waited on.
+     */
+    template <class A>
+    void addDependency() { assert( !_isFinalised); _deps.insert( &A::staticMetaObject);}
+
     /**
      * Returns the client set mouse position. Returns (-1,-1) if not set.
      * Always reset to (-1,-1) after doAfterAction executes.
      */
     const QPoint& primedMousePos() const { return _mpos;}
 
+    /**
+     * Returns true iff the current (or just finished) work was cancelled.
+     * Use in doAfterAction to avoid reporting or emitting events for work not done.
+     */
+    bool isCancelled() const { return _task && _task->isCancelled();}
+
     /**
      * Derived actions may cache data against a model. This function is called to purge these data
      * because of events specified using addPurgeEvent or due to other conditions that can invalidate
@@ -261,7 +285,8 @@ protected:
     virtual void restoreState( const UndoState&);   // Has default ERROR implementation!
 
 private slots:
-    void _endExecute( Event);
+    void _endExecute( Event, FM*);
+    void _abortExecute();
 
 private:
     QAction _action;
@@ -279,6 +304,11 @@ private:
     QPoint _mpos;   // The primed mouse position
     bool _isFinalised;
     std::string _dbgPrfx;
+    std::unordered_set<const QMetaObject*> _deps;  // Types of actions depended upon
+    TaskState::Ptr _task;   // Cancellation and progress of current work
+    int64_t _tstart;        // Trace time execution started
+
+    bool _dependsOn( const FaceAction*) const;
 
     void _pinit();
 
@@ -19,12 +19,21 @@
 #define FACE_TOOLS_FACE_ACTION_MANAGER_H
 
 #include "FaceAction.h"
+#include <QTimer>
 
 /**
  * IMPORTANT:
  * Before creating the singleton FaceActionManager, ensure that all FaceModelViewer instances
  * have been added using ModelSelect::addViewer since all interactors and mouse handlers
  * will attach themselves to all available viewers on creation.
+ *
+ * Actions triggered by events raised outside of an action cascade aren't executed immediately.
+ * Instead, the events are merged per model and the triggered actions are executed once each
+ * (with the union of the events that triggered them) after COALESCE_MSECS. This way, a burst
+ * of events (e.g. the several events emitted across a multi-step operation like detection)
+ * causes just one execution of each responding action. Every model with pending actions is
+ * flushed (bound via ModelSelect::bindModel) and actions still running at the time are kept
+ * pending for the next window.
  */
 
 namespace FaceTools { namespace Action {
@@ -44,17 +53,31 @@ public:
     // Raise the given event (always raised in the GUI thread).
     static void raise( Event);
 
+    // Schedule the given action to execute (with the given event) on the given model after
+    // the current coalescing window. Can be called from any thread. Ignored if the model
+    // is closed in the meantime.
+    static void schedule( FaceAction*, const FM*, Event);
+
     static Vis::FV* close( const FM*);
 
     static FaceActionManager* get();    // For connecting to signals
 
+    // Window over which events are merged before executing the actions they trigger.
+    static const int COALESCE_MSECS;
+
 signals:
+    // Emitted for every event raised against a model (before coalescing) with the
+    // action that raised it (null if not raised by an action).
+    void onRaised( const FM*, Event, const FaceAction*);
+
     void onUpdateSelected();
     void onShowHelp( const QString&);
     void _selfRaise( Event);
 
 private slots:
     void _doRaise( Event e=Event::NONE);
+    void _doFlush();
+    void _doSchedule( FaceAction*, const FM*, Event);
 
 private:
     static FaceActionManager::Ptr s_singleton;
@@ -63,6 +86,10 @@ private:
     int _lvl;
     std::unordered_map<FaceAction*, Event> _acted;
 
+    QTimer _ctimer; // Coalescing window
+    // Actions (and their merged triggering events) pending execution per model.
+    std::unordered_map<const FM*, std::unordered_map<FaceAction*, Event> > _pending;
+
     FaceActionManager();
     FaceActionManager( const FaceActionManager&) = delete;
     void operator=( const FaceActionManager&) = delete;
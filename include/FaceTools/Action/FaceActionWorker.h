@@ -19,25 +19,50 @@
 #define FACE_TOOLS_ACTION_FACE_ACTION_WORKER_H
 
 #include <FaceTools/FaceTypes.h>
+#include <FaceTools/TaskState.h>
+#include <QThreadPool>
+#include <QRunnable>
 #include <QTimer>
-#include <QThread>
 #include <QMutex>
+#include <list>
 
 namespace FaceTools { namespace Action {
 
 class FaceAction;
 
-class FaceTools_EXPORT FaceActionWorker : public QThread
+/**
+ * The asynchronous work of a FaceAction bound to the model that was selected when the
+ * action was executed. Workers run on a persistent pool of threads rather than each
+ * creating its own. A worker whose action depends on other actions (see FaceAction::addDependency)
+ * isn't started until all earlier scheduled workers of those actions for the same model have
+ * finished, at which point it's started from the pool thread that finished the last of them.
+ * Workers for different models, and for independent actions, run concurrently.
+ */
+class FaceTools_EXPORT FaceActionWorker : public QObject, public QRunnable
 { Q_OBJECT
 public:
-    FaceActionWorker( FaceAction*, Event);
-    virtual ~FaceActionWorker();
+    FaceActionWorker( FaceAction*, Event, FM*, const TaskState::Ptr&);
+    ~FaceActionWorker() override;
 
     // True if at least one user instigated worker is active
     static bool isUserWorking() { return _s_userWorkCount > 0;}
 
+    // Schedule the worker to run on the pool as soon as its dependencies allow.
+    // The worker should be deleted (later) after emitting onWorkFinished or onWorkDropped.
+    static void schedule( FaceActionWorker*);
+
+    // Drop the workers for the given model that haven't yet started (each emits onWorkDropped).
+    static void purge( const FM*);
+
+    // Request cancellation of the running workers for the given model (see TaskState).
+    static void cancel( const FM*);
+
+    // The pool of threads shared by all workers.
+    static QThreadPool* pool();
+
 signals:
     void onWorkFinished( Event);
+    void onWorkDropped();
 
 protected:
     void run() override;
@@ -48,13 +73,19 @@ private slots:
 private:
     FaceAction* _worker;
     Event _event;
+    FM *_fm;
+    TaskState::Ptr _task;
+    bool _started;
     QTimer *_timer;
     int _tcount;
     QString _status;
 
     static int _s_userWorkCount;
     static QMutex _s_mutex;
+    static std::list<FaceActionWorker*> _s_live;    // Scheduled and not finished in scheduled order
 
+    bool _isBlocked() const;
+    static void _startUnblocked();
     void _deleteTimer();
 };  // end class
 
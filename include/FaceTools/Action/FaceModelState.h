@@ -32,6 +32,31 @@ public:
 
     void restore( const Event&) const;   // Called by UndoState
 
+    // Approximate bytes held in memory by this state that aren't shared with the
+    // model or any other state (i.e. what spilling would free). Called by UndoState.
+    size_t memoryUsage() const;
+
+    // Return the mesh to spill to file or null if spilling it wouldn't free memory. While the
+    // caller holds the returned mesh, memoryUsage returns zero. Called by UndoState.
+    r3d::Mesh::Ptr spillMesh() const;
+
+    // Once the given mesh (from spillMesh) is written to fpath, release it from memory so that
+    // it's read back on restore. Returns false (leaving the state unchanged) if the state no
+    // longer solely holds the mesh (e.g. it was restored in the meantime). Called by UndoState.
+    bool setSpilled( const r3d::Mesh::Ptr&, const QString &fpath);
+    inline bool isSpilled() const { return !_spill.isEmpty();}
+
+    // Read a spilled mesh back into memory (nothing to do if not spilled). Returns false
+    // if the mesh couldn't be read in which case the state can't be restored. Called by UndoState.
+    bool unspill();
+
+    // Rough estimate of the bytes held by the given mesh.
+    static size_t meshBytes( const r3d::Mesh&);
+
+    // Write/read a mesh (including its transform) to/from a spill file.
+    static bool writeSpill( const r3d::Mesh&, const QString&);
+    static r3d::Mesh::Ptr readSpill( const QString&);
+
 private:
     FM *_fm;
     bool _metaSaved;
@@ -50,6 +75,7 @@ private:
     r3d::Mesh::Ptr _mesh;
     r3d::KDTree::Ptr _kdtree;
     r3d::Manifolds::Ptr _manifolds;
+    QString _spill;     // File holding the mesh if spilled
 
     std::vector<r3d::Bounds::Ptr> _bnds;
 
@@ -80,7 +106,7 @@ private:
     FaceModelState( FM*, Event);
     FaceModelState( const FaceModelState&) = delete;
     FaceModelState& operator=( const FaceModelState&) = delete;
-    ~FaceModelState(){}
+    ~FaceModelState();
 };  // end class
 
 }}   // end namespaces
@@ -43,6 +43,8 @@ public:
     void setUserData( const QString&, const QVariant&);
 
     // Return the data keyed by the given string (no error checking!).
+    // Meshes spilled to file while the state was held are read back before
+    // FaceAction::restoreState is called (which isn't called if that fails).
     QVariant userData( const QString&) const;
 
     inline const Event& events() const { return _egrp;}
@@ -58,16 +60,37 @@ private:
     QString _name;
     FM *_sfm;
     std::vector<FaceModelState::Ptr> _fstates;  // The auto restore states (if being used)
-    QMap<QString, QVariant> _udata; // The manually set state (if being used)
+    mutable QMap<QString, QVariant> _udata; // The manually set state (if being used)
+    mutable QMap<QString, QString> _uspill; // Files holding spilled user data meshes
+    size_t _seq;    // Creation order across all models
+
+    struct SpillJob
+    {
+        r3d::Mesh::Ptr mesh;    // The mesh to write (held until written)
+        QString fpath;          // The file to write it to
+        int fidx;               // Index of the model state holding the mesh or -1 if user data
+        QString key;            // The user data key (if fidx < 0)
+        bool written;           // Set once the mesh is written to fpath
+    };  // end struct
+    bool _spilling; // True while spill jobs are outstanding
+
+    size_t memoryUsage() const;         // Called by UndoStates
+
+    // Return the meshes to spill to files prefixed with fpfx. These are written away from
+    // the state before being passed back to setSpilled to release them from memory. No
+    // further jobs are returned and memoryUsage returns zero until then.
+    std::vector<SpillJob> spillJobs( const QString &fpfx);  // Called by UndoStates
+    void setSpilled( const std::vector<SpillJob>&);         // Called by UndoStates
 
     UndoState( const FaceAction*, Event, bool);
     UndoState( const UndoState&) = delete;
     UndoState& operator=( const UndoState&) = delete;
-    ~UndoState(){}
+    ~UndoState();
 
     inline bool isAutoRestore() const { return _autoRestore;}
     inline const FaceAction* action() const { return _action;}
-    Event restore() const;   // Called by UndoStates
+    bool _unspill() const;
+    Event restore() const;   // Called by UndoStates (returns Event::NONE if unable to restore)
     static Ptr create( const FaceAction*, Event, bool autoRestore=false);  // Called by UndoStates
 
     friend class UndoStates;
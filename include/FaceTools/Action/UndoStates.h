@@ -20,6 +20,7 @@
 
 #include "UndoState.h"
 #include <QReadWriteLock>
+#include <QTemporaryDir>
 #include <deque>
 
 namespace FaceTools { namespace Action {
@@ -30,6 +31,17 @@ public:
     // Undo/redo states per model cannot exceeed MAX_RESTORES.
     static const size_t MAX_RESTORES = 30;
 
+    // Set the budget in bytes for the memory held by undo/redo states across all models
+    // (512MB by default). When exceeded, the meshes held by the oldest states are spilled
+    // to temporary files (from which they're read back if restored) and if that doesn't
+    // bring usage within budget, the oldest undo states are discarded. Zero means unlimited.
+    // Spill files are written in the background (on a dedicated thread).
+    static void setBudget( size_t);
+    static size_t budget();
+
+    // Returns the approximate number of bytes held in memory by undo/redo states.
+    static size_t usage();
+
     // Clear the undo/redo stacks for the given model (should happen on save/close).
     static void clear( const FM*);
     static void clear();    // Clear all undo/redos
@@ -73,6 +85,16 @@ private:
     std::unordered_map<const FM*, Stacks> _stacks;
 
     QReadWriteLock _mutex;
+    size_t _budget;
+    QTemporaryDir *_sdir;   // Spill directory (created on first spill)
+
+    using SpillJobs = std::vector<std::pair<std::weak_ptr<UndoState>, std::vector<UndoState::SpillJob> > >;
+
+    UndoStates();
+    ~UndoStates() override;
+    size_t _usage() const;
+    SpillJobs _enforceBudget();
+    void _spill( SpillJobs&&);
 
     void _clear( const FM*);
     void _clear();
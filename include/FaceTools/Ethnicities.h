@@ -127,6 +127,25 @@ public:
      */
     static int makeMixedCode( const IntSet&);
 
+    /**
+     * Returns the dense index of the given code into the containment closure compiled
+     * at load time, or -1 if the code is not known. Indices remain valid until the next
+     * call to load. Callers comparing many codes against the same few should look up
+     * the indices once and use parentDegreeAt / belongsAt instead of the code based functions.
+     */
+    static int index( int code);
+
+    /**
+     * As parentDegree but for the dense indices returned by index().
+     * Returns -1 if either index is out of range.
+     */
+    static int parentDegreeAt( int pidx, int cidx, bool allBelong=false);
+
+    /**
+     * As belongs but for the dense indices returned by index().
+     */
+    static bool belongsAt( int pidx, int cidx, bool allBelong=false) { return parentDegreeAt( pidx, cidx, allBelong) >= 0;}
+
 private:
     static std::list<int> _codes;                    // All numerically ascending codes (not temporaries).
     static std::unordered_map<int, QString> _names;  // Four digit codes to all names.
@@ -134,6 +153,11 @@ private:
     static std::unordered_map<int, IntSet> _groups;  // Code groupings parent to child
     static std::unordered_map<int, IntSet> _rgroups; // Code groupings child to parents
     static int _lt;
+    static std::unordered_map<int, int> _index;      // Codes to dense closure indices
+    static std::vector<int> _icodes;                 // Dense closure indices to codes
+    static std::vector<std::vector<int8_t> > _closure[2];  // [allBelong][parent][child] degree or -1
+
+    static void _addToClosure( int);
 
     static QString _makeMixedName( const IntSet&);
 
@@ -50,7 +50,9 @@ public:
      * If settleLandmarks is true, landmarks and other items that rest on the surface are reseated.
      * This should normally be true unless setting the mesh for the first time after reading
      * in landmark/path positions. If maxManifolds > 0, this will override the default number
-     * of manifolds to set (MAX_MANIFOLDS).
+     * of manifolds to set (MAX_MANIFOLDS). Where connectivity isn't updated and the new mesh has
+     * the same transformed vertex positions (e.g. only the transform was fixed or the face winding
+     * changed), the existing search tree (and bounds if the transform is unchanged) are kept.
      * View actors should be rebuilt after calling this function.
      */
     void update( r3d::Mesh::Ptr, bool updateConnectivity, bool settleLandmarks, int maxManifolds=-1);
@@ -350,7 +352,9 @@ private:
     friend class Action::FaceModelState;
 
     bool _moveToSurface();
+    void _makeBounds();
     void _syncBoundsToAlignment();
+    static bool _sameVertices( const r3d::Mesh&, const r3d::Mesh&);
     FaceModel( const FaceModel&) = delete;
     void operator=( const FaceModel&) = delete;
 };  // end class
@@ -21,6 +21,7 @@
 #include "FaceTypes.h"
 #include <r3d/Curvature.h>
 #include <vtkFloatArray.h>
+#include <mutex>
 
 namespace FaceTools {
 
@@ -31,9 +32,14 @@ public:
 
     static Ptr create( const r3d::Mesh&);
 
-    const r3d::Curvature &vals() const { return *_cmap;}
+    // Create from previously calculated arrays (mean, abs, D2 and normals in that order) returning
+    // null if they don't correspond to the mesh. The curvature map itself isn't calculated until
+    // first accessed through vals().
+    static Ptr create( const r3d::Mesh&, const std::vector<vtkSmartPointer<vtkFloatArray> >&);
 
-    r3d::Curvature &vals() { return *_cmap;}
+    const r3d::Curvature &vals() const { return _map();}
+
+    r3d::Curvature &vals() { return _map();}
 
     // Call this if changes made to the curvature map.
     void updateArrays();
@@ -44,14 +50,20 @@ public:
     vtkSmartPointer<vtkFloatArray> d2Array() const { return _dcrv;}     // Scalars
     vtkSmartPointer<vtkFloatArray> normals() const { return _nrms;}     // 3-vectors
 
+    // Approximate number of bytes used.
+    size_t memoryUsage() const;
+
 private:
-    r3d::Curvature::Ptr _cmap;
+    const r3d::Mesh &_mesh;
+    mutable r3d::Curvature::Ptr _cmap;
+    mutable std::once_flag _cmapOnce;
     vtkSmartPointer<vtkFloatArray> _nrms;
     vtkSmartPointer<vtkFloatArray> _mcrv;
     vtkSmartPointer<vtkFloatArray> _dcrv;
     vtkSmartPointer<vtkFloatArray> _acrv;
 
-    FaceModelCurvature( const r3d::Mesh&);
+    r3d::Curvature &_map() const;
+    explicit FaceModelCurvature( const r3d::Mesh&);
     ~FaceModelCurvature();
     FaceModelCurvature( const FaceModelCurvature&) = delete;
     void operator=( const FaceModelCurvature&) = delete;
@@ -19,10 +19,17 @@
 #define FACE_TOOLS_FACE_MODEL_CURVATURE_STORE_H
 
 #include "FaceModelCurvature.h"
+#include "SurfaceDataBudget.h"
 #include "FaceModel.h"
+#include <unordered_set>
 
 namespace FaceTools {
 
+// Memory used is accounted against the SurfaceDataBudget. Entries evicted to stay
+// within it are returned as null when next requested while they're recalculated
+// asynchronously (by the action the store's recalculator schedules).
+// Each model's curvature data has its own lock so the data for one model
+// can be read while the data for another is being calculated or modified.
 class FaceTools_EXPORT FaceModelCurvatureStore
 {
 public:
@@ -30,22 +37,31 @@ public:
     using WPtr = std::shared_ptr<FaceModelCurvature>;
 
     // Returns the curvature map for the given model or null if not available.
-    // Read lock is held while returned shared ptr is alive.
+    // Read lock for the model's data is held while returned shared ptr is alive.
     static RPtr rvals( const FM&);
 
     // Returns the curvature map for the given model or null if not available.
-    // Write lock is held while returned shared ptr is alive.
+    // Write lock for the model's data is held while returned shared ptr is alive.
     static WPtr wvals( const FM&);
 
     // Delete curvature data associated with the given model.
     static void purge( const FM&);
 
-    // Create and add curvature data for the given model.
+    // Create and add curvature data for the given model. If arrays read in with the model's
+    // archive are still held (see SurfaceDataArchive) for the model's current content, they're used.
     static void add( const FM&);
 
+    // Name of this store and the hash of the model content its data are calculated over.
+    static QString name();
+    static size_t contentHash( const FM&);
+
 private:
-    static std::unordered_map<const FM*, FaceModelCurvature::Ptr> _metrics;
-    static QReadWriteLock _lock;
+    using Entry = SurfaceDataEntry<FaceModelCurvature>;
+    static std::unordered_map<const FM*, Entry::Ptr> _metrics;
+    static std::unordered_set<const FM*> _evicted;  // Models with data evicted to be recalculated on demand
+    static QReadWriteLock _lock;    // Only for the maps (never held while calculating)
+    static Entry::Ptr _entry( const FM&);
+    static int _storeId();
 };  // end class
 
 }   // end namespace
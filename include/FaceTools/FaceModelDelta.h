@@ -19,6 +19,7 @@
 #define FACE_TOOLS_FACE_MODEL_DELTA_H
 
 #include "FaceTypes.h"
+#include "TaskState.h"
 #include <vtkFloatArray.h>
 #include <r3d/Mesh.h>
 
@@ -29,8 +30,9 @@ class FaceTools_EXPORT FaceModelDelta
 public:
     using Ptr = std::shared_ptr<FaceModelDelta>;
 
-    // Create and return the delta between the two models iff
-    // the underlying masks match otherwise return null.
+    // Create and return the delta between the two models iff the underlying masks
+    // match otherwise return null. Also returns null if the work on the calling
+    // thread is cancelled while calculating (see TaskState).
     static Ptr create( const FM *tgt, const FM *src);
 
     inline const FM *target() const { return _tgt;}
@@ -47,6 +49,9 @@ public:
     vtkSmartPointer<vtkFloatArray> vecsArray() const { return _vecsArr;}
     vtkSmartPointer<vtkFloatArray> sclsArray() const { return _sclsArr;}
 
+    // Approximate number of bytes used.
+    size_t memoryUsage() const;
+
 private:
     const FM *_tgt;
     const FM *_src;
@@ -58,8 +63,8 @@ private:
         Vec3f dvector;  // Difference of target from source
         Vec3f scalars;  // Scalar values as below:
     };  // end struct
-    std::unordered_map<int, VtxVals> _maskVtxVals;  // Mask vertex differences
-    std::unordered_map<int, Vec3f> _targVtxVals;  // Target vertex scalars (perp, angd, smag)
+    std::vector<VtxVals> _maskVtxVals;  // Mask vertex differences (indexed by mask vertex)
+    std::vector<Vec3f> _targVtxVals;    // Target vertex scalars (perp, angd, smag) indexed by vertex
 
     vtkSmartPointer<vtkFloatArray> _perpArr;    // For target face
     vtkSmartPointer<vtkFloatArray> _angdArr;    // For target face
@@ -67,8 +72,8 @@ private:
     vtkSmartPointer<vtkFloatArray> _vecsArr;    // For source mask
     vtkSmartPointer<vtkFloatArray> _sclsArr;    // For source mask
 
-    void _calcMaskVtxVals();
-    void _calcTargetMeshVtxVals();
+    void _calcMaskVtxVals( TaskState*);
+    void _calcTargetMeshVtxVals( TaskState*);
     FaceModelDelta( const FM *tgt, const FM *src);
     ~FaceModelDelta();
     FaceModelDelta( const FaceModelDelta&) = delete;
@@ -19,16 +19,22 @@
 #define FACE_TOOLS_FACE_MODEL_DELTA_STORE_H
 
 #include "FaceModelDelta.h"
-#include <QReadWriteLock>
+#include "SurfaceDataBudget.h"
+#include <set>
 
 namespace FaceTools {
 
 using FMD = FaceModelDelta;
 
+// Memory used is accounted against the SurfaceDataBudget. Entries evicted to stay
+// within it are returned as null when next requested while they're recalculated
+// asynchronously (by the action the store's recalculator schedules).
+// Each target/source pair has its own lock so the delta for one pair can
+// be read while the delta for another is being calculated.
 class FaceTools_EXPORT FaceModelDeltaStore
 {
 public:
-    // Read lock is held while returned shared ptr is alive.
+    // Read lock for the pair's data is held while returned shared ptr is alive.
     static std::shared_ptr<const FMD> vals( const FM *tgt, const FM *src);
 
     // Set the differences on tgt to be from src.
@@ -39,11 +45,18 @@ public:
     // Purge associated deltas for the given model.
     static void purge( const FM*);
 
+    // Name of this store.
+    static QString name();
+
 private:
-    static std::unordered_map<const FM*, std::unordered_map<const FM*, FMD::Ptr> > _t2s;
-    static std::unordered_map<const FM*, std::unordered_map<const FM*, FMD::Ptr> > _s2t;
-    static QReadWriteLock _lock;
+    using Entry = SurfaceDataEntry<FMD>;
+    static std::unordered_map<const FM*, std::unordered_map<const FM*, Entry::Ptr> > _t2s;
+    static std::unordered_map<const FM*, std::unordered_map<const FM*, Entry::Ptr> > _s2t;
+    static std::set<std::pair<const FM*, const FM*> > _evicted;  // Target/source pairs evicted
+    static QReadWriteLock _lock;    // Only for the maps (never held while calculating)
     static bool _has( const FM *tgt, const FM *src);
+    static void _erase( const FM *tgt, const FM *src);
+    static int _storeId();
 };  // end class
 
 }   // end namespace
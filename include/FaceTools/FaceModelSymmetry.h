@@ -19,6 +19,7 @@
 #define FACE_TOOLS_FACE_MODEL_SYMMETRY_H
 
 #include "FaceTypes.h"
+#include "TaskState.h"
 #include <vtkFloatArray.h>
 
 namespace FaceTools {
@@ -28,22 +29,32 @@ class FaceTools_EXPORT FaceModelSymmetry
 public:
     using Ptr = std::shared_ptr<FaceModelSymmetry>;
 
+    // Returns null if the work on the calling thread is cancelled while calculating (see TaskState).
     static Ptr create( const FM*);
 
+    // Create from previously calculated arrays (x, y, z and all in that
+    // order) returning null if they don't correspond to the model's mesh.
+    static Ptr create( const FM*, const std::vector<vtkSmartPointer<vtkFloatArray> >&);
+
     vtkSmartPointer<vtkFloatArray> allArray() const { return _allarr;}
     vtkSmartPointer<vtkFloatArray> xArray() const { return _xarr;}
     vtkSmartPointer<vtkFloatArray> yArray() const { return _yarr;}
     vtkSmartPointer<vtkFloatArray> zArray() const { return _zarr;}
 
+    // Approximate number of bytes used.
+    size_t memoryUsage() const;
+
 private:
-    std::unordered_map<int, Vec4f> _vtxSymm;
+    // Per vertex asymmetry (x, y, z, all) indexed by vertex ID
+    std::vector<Vec4f, Eigen::aligned_allocator<Vec4f> > _vtxSymm;
     vtkSmartPointer<vtkFloatArray> _allarr;
     vtkSmartPointer<vtkFloatArray> _xarr;
     vtkSmartPointer<vtkFloatArray> _yarr;
     vtkSmartPointer<vtkFloatArray> _zarr;
 
-    void _makeVtxSymm( const FM*);
+    void _makeVtxSymm( const FM*, TaskState*);
     explicit FaceModelSymmetry( const FM*);
+    FaceModelSymmetry() {}
     ~FaceModelSymmetry();
     FaceModelSymmetry( const FaceModelSymmetry&) = delete;
     void operator=( const FaceModelSymmetry&) = delete;
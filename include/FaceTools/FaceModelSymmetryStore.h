@@ -19,22 +19,36 @@
 #define FACE_TOOLS_FACE_MODEL_SYMMETRY_STORE_H
 
 #include "FaceModelSymmetry.h"
-#include <QReadWriteLock>
+#include "SurfaceDataBudget.h"
+#include <unordered_set>
 
 namespace FaceTools {
 
+// Memory used is accounted against the SurfaceDataBudget. Entries evicted to stay
+// within it are returned as null when next requested while they're recalculated
+// asynchronously (by the action the store's recalculator schedules).
+// Each model's symmetry data has its own lock so the data for one model
+// can be read while the data for another is being calculated.
 class FaceTools_EXPORT FaceModelSymmetryStore
 {
 public:
-    // Read lock is held while returned shared ptr is alive.
+    // Read lock for the model's data is held while returned shared ptr is alive.
     static std::shared_ptr<const FaceModelSymmetry> vals( const FM*);
     static bool isMapped( const FM*);
     static void add( const FM*);
     static void purge( const FM*);
 
+    // Name of this store and the hash of the model content its data are
+    // calculated over (the mesh, model mask and the anthropometric mask).
+    static QString name();
+    static size_t contentHash( const FM*);
+
 private:
-    static std::unordered_map<const FM*, FaceModelSymmetry::Ptr> _vtxSymm;
-    static QReadWriteLock _lock;
+    using Entry = SurfaceDataEntry<FaceModelSymmetry>;
+    static std::unordered_map<const FM*, Entry::Ptr> _vtxSymm;
+    static std::unordered_set<const FM*> _evicted;  // Models with data evicted to be recalculated on demand
+    static QReadWriteLock _lock;    // Only for the maps (never held while calculating)
+    static int _storeId();
 };  // end class
 
 }   // end namespace
@@ -0,0 +1,84 @@
+/************************************************************************
+ * Copyright (C) 2021 SIS Research Ltd & Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#ifndef FACE_TOOLS_FILE_IO_BATCH_PROCESSOR_H
+#define FACE_TOOLS_FILE_IO_BATCH_PROCESSOR_H
+
+/**
+ * Runs the detect / extract / measure / export pipeline over model files without
+ * requiring any of the GUI actions or an event loop. Clients must have loaded the
+ * landmarks, metrics, phenotypes (and optionally stats) and - if detecting - have
+ * initialised the features detector and loaded the mask (see MaskRegistration::setMask)
+ * before processing. Output 3DF and CSV files are written into the output directory.
+ */
+
+#include "FaceModelManager.h"
+
+namespace FaceTools { namespace FileIO {
+
+class FaceTools_EXPORT BatchProcessor
+{
+public:
+    // Per file processing result.
+    struct Result
+    {
+        QString inpath;     // The file that was read in
+        QString outpath;    // The 3DF file written (empty on error)
+        QString err;        // The nature of the error (empty on success)
+        size_t nhpos;       // Number of phenotypic indications discovered
+    };  // end struct
+
+    explicit BatchProcessor( const QString &outdir);
+
+    // Set whether the face is detected (mask registered and landmarks placed).
+    // Default true. If false, the model's existing mask and landmarks are used.
+    void setDetect( bool v) { _detect = v;}
+
+    // Set whether the facial region is extracted after detection. Default true.
+    void setExtract( bool v) { _extract = v;}
+
+    // Set whether the CSV summary for each model is written alongside its 3DF. Default true.
+    void setWriteCSV( bool v) { _writeCSV = v;}
+
+    // Returns true iff the output directory exists or could be created.
+    bool isValid() const;
+
+    // Process the model at the given path returning the result.
+    Result process( const QString &fpath) const;
+
+    // Process every readable model file in the given directory (not recursive) returning
+    // the results in filename order. Files are processed concurrently on the shared pool
+    // (see parallelFor) using at most maxThreads threads (including the calling thread which
+    // blocks until all are done). If maxThreads is zero, the pool's size is the limit.
+    // The optional callback is given each result as it's made. Calls are serialised but
+    // are made from the processing threads (in no particular order).
+    std::vector<Result> processDirectory( const QString &indir,
+                                          const std::function<void( const Result&)>& cb=nullptr,
+                                          size_t maxThreads=0) const;
+
+private:
+    QString _outdir;
+    bool _detect;
+    bool _extract;
+    bool _writeCSV;
+
+    QString _process( FM&, Result&) const;
+};  // end class
+
+}}   // end namespaces
+
+#endif
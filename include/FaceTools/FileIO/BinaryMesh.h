@@ -0,0 +1,53 @@
+/************************************************************************
+ * Copyright (C) 2021 SIS Research Ltd & Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#ifndef FACE_TOOLS_FILE_IO_BINARY_MESH_H
+#define FACE_TOOLS_FILE_IO_BINARY_MESH_H
+
+/**
+ * Compact binary serialisation of a mesh for storage inside 3DF archives.
+ * All values are written little-endian regardless of host byte order.
+ *
+ * Layout (version 1):
+ *   char[4]  magic "R3DB"
+ *   uint32   version
+ *   uint32   #vertices V, then V x 3 float32 (transformed vertex positions)
+ *   uint32   #faces F, then F x 3 int32 (vertex indices into the vertex block)
+ *   uint32   #materials M, then for each material:
+ *     uint32   #bytes B, then B bytes of the PNG encoded texture
+ *     uint32   #faces N, then N x (int32 face index, 6 x float32 ordered face UVs)
+ */
+
+#include <FaceTools/FaceTypes.h>
+#include <r3d/Mesh.h>
+
+namespace FaceTools { namespace FileIO {
+
+static const QString BINARY_MESH_EXTENSION = "bin";
+static const uint32_t BINARY_MESH_VERSION = 1;
+
+// Write the mesh to the given stream/file returning true on success.
+FaceTools_EXPORT bool writeBinaryMesh( const r3d::Mesh&, std::ostream&);
+FaceTools_EXPORT bool writeBinaryMesh( const r3d::Mesh&, const QString &fpath);
+
+// Read a mesh from the given stream/file returning null on failure.
+FaceTools_EXPORT r3d::Mesh::Ptr readBinaryMesh( std::istream&);
+FaceTools_EXPORT r3d::Mesh::Ptr readBinaryMesh( const QString &fpath);
+
+}}   // end namespaces
+
+#endif
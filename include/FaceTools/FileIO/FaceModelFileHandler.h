@@ -19,6 +19,7 @@
 #define FACE_TOOLS_FILE_IO_FACE_MODEL_FILE_HANDLER_H
 
 #include <FaceTools/FaceModel.h>
+#include <QMutex>
 
 namespace FaceTools { namespace FileIO {
 
@@ -42,10 +43,19 @@ public:
     virtual FM* read( const QString&);              // Must override if canRead overridden to true
     virtual bool write( const FM*, const QString&); // Must override if canWrite overridden to true
 
+    // Read that may be called concurrently from multiple threads with the error (if any) set in
+    // the out parameter. The default implementation serialises calls to read and error for this
+    // handler. Handlers that can read files independently of their own state should override.
+    virtual FM* readReentrant( const QString&, QString &err);
+
+    // Write that may be called concurrently from multiple threads as for readReentrant.
+    virtual bool writeReentrant( const FM*, const QString&, QString &err);
+
 protected:
     static void setImageCaptureDate( FM*, const QString&);
 
 private:
+    QMutex _rmutex; // Serialises the default reentrant reads and writes
     FaceModelFileHandler( const FaceModelFileHandler&) = delete;
     void operator=( const FaceModelFileHandler&) = delete;
 };  // end class
@@ -19,9 +19,14 @@
 #define FACE_TOOLS_FILE_IO_FACE_MODEL_MANAGER_H
 
 #include "FaceModelFileHandlerMap.h"
+#include <QReadWriteLock>
+#include <QSet>
+#include <functional>
 
 namespace FaceTools { namespace FileIO {
 
+// All functions are safe to call from multiple threads though
+// the file handlers should only be added from a single thread.
 class FaceTools_EXPORT FaceModelManager
 {
 public:
@@ -63,11 +68,27 @@ public:
     // Load in a model (returning null on fail). Also returns null if model already open.
     static FM* read( const QString&);
 
-    // Get the nature of the error if read returns null or write returns false.
-    static const QString& error() { return _err;}
+    struct ReadResult
+    {
+        QString filepath;
+        FM *model = nullptr;    // Null if failed to read
+        QString error;          // Nature of the error if model is null
+    };  // end struct
+
+    // Called after each file is read with the number of files read so far and the total.
+    // Calls are serialised but are made from the reading threads.
+    using ReadCallback = std::function<void( const ReadResult&, size_t ndone, size_t total)>;
+
+    // Read the given files concurrently on the shared pool (see parallelFor) using at most maxThreads
+    // threads (including the calling thread which blocks until all are read). If maxThreads is zero,
+    // the pool's size is the limit. Results are returned in the same order as the given filepaths.
+    static std::vector<ReadResult> read( const QStringList&, const ReadCallback &cb=nullptr, size_t maxThreads=0);
+
+    // Get the nature of the error if read returns null or write returns false (in the calling thread).
+    static QString error();
 
     // Return the filepath for the model.
-    static const QString& filepath( const FM&);
+    static QString filepath( const FM&);
 
     // Return the open model for the given filepath or null if not open.
     static FM* model( const QString&);
@@ -80,11 +101,11 @@ public:
     static void close( const FM&);
 
     // Returns the number of models currently open.
-    static size_t numOpen() { return _mdata.size();}
+    static size_t numOpen();
     static size_t loadLimit() { return _loadLimit;}  // Load limit not enforced by FaceModelManager (clients must do this)
 
     // Get the complete set of models currently open.
-    static const FMS& opened() { return _models;}
+    static FMS opened();
 
     static void printFormats( std::ostream&);    // Prints the accepted file formats
 
@@ -94,8 +115,10 @@ private:
     static FMS _models;
     static std::unordered_map<FM*, QString> _mdata;
     static std::unordered_map<QString, FM*> _mfiles;    // Lookup models by current filepath
-    static QString _err;
+    static QSet<QString> _loading;                      // Filepaths currently being read
+    static QReadWriteLock _lock;
     static void _setModelFilepath( const FM&, const QString&);
+    static FM* _read( const QString&, QString &err);
 };  // end class
 
 }}   // end namespaces
@@ -23,7 +23,7 @@
 
 namespace FaceTools { namespace FileIO {
 
-static const QString XML_VERSION = "5.1";
+static const QString XML_VERSION = "5.2";  // 5.2 stores the mesh in binary format
 static const QString XML_FILE_EXTENSION = "3df";
 static const QString XML_FILE_DESCRIPTION = "3D Face Image and Metadata";
 
@@ -44,10 +44,16 @@ public:
     FM* read( const QString& filepath) override;
     bool write( const FM*, const QString& filepath) override;
 
+    // Reading and writing don't depend on handler state so can be done concurrently.
+    FM* readReentrant( const QString& filepath, QString &err) override;
+    bool writeReentrant( const FM*, const QString& filepath, QString &err) override;
+
 private:
     QStringSet _exts;
     QString _err;
     double _fversion;   // File version read in
+    static FM* _read( const QString&, QString &err, double &fversion);
+    static bool _write( const FM*, const QString&, QString &err);
 };  // end class
 
 
@@ -55,6 +61,12 @@ private:
 // Returns a non-empty string on error which contains the nature of the error.
 FaceTools_EXPORT QString readMeta( const QString &fname, QTemporaryDir &extractDir, PTree &tree);
 
+// Read meta data from a 3DF file into the given property tree without extracting the archive.
+// Only the metadata entry is decompressed (into memory). If thumb is not null, it is set
+// to the archive's thumbnail image (or left empty if not present).
+// Returns a non-empty string on error which contains the nature of the error.
+FaceTools_EXPORT QString readMeta( const QString &fname, PTree &tree, cv::Mat *thumb=nullptr);
+
 // Import metadata from a property tree for the given model, setting file
 // version and the mesh and mask filenames and returning true iff successful.
 FaceTools_EXPORT bool importMetaData( FM&, const PTree&, double &fversion, QString &meshfname, QString &maskfname);
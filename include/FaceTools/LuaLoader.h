@@ -0,0 +1,64 @@
+/************************************************************************
+ * Copyright (C) 2021 SIS Research Ltd & Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#ifndef FACE_TOOLS_LUA_LOADER_H
+#define FACE_TOOLS_LUA_LOADER_H
+
+/**
+ * Runs the Lua files defining metrics, statistics, phenotypes and reports. Compiled chunks
+ * are cached on disk keyed by the hash of their source (and the Lua version and build format)
+ * so unchanged files are not parsed again on subsequent runs. The cache is kept in a directory
+ * private to the user and chunks are only loaded from files that no one else can write to.
+ * Loaders that only read tables from a file can use the state shared by the calling thread
+ * rather than creating a new state for every file.
+ */
+
+#include "FaceTypes.h"
+#include <sol.hpp>
+
+namespace FaceTools {
+
+class FaceTools_EXPORT LuaLoader
+{
+public:
+    // Returns the state (with the base library opened) shared by all loaders running in
+    // the calling thread. Run files in it with scriptFileIsolated.
+    static sol::state &sharedState();
+
+    // Run the Lua file at the given path as for scriptFile but with a new environment as its
+    // globals (reading through to the state's globals) so that the globals it sets don't persist
+    // into other files run in the same state. Returns the environment holding those globals.
+    static sol::environment scriptFileIsolated( sol::state&, const QString &fpath);
+
+    // Run the Lua file at the given path in the given state using the compiled chunk
+    // from the cache if available. Throws sol::error on failure (like script_file).
+    static void scriptFile( sol::state&, const QString &fpath);
+
+    // As scriptFile but for source code already read in with the given chunk name.
+    static void script( sol::state&, const QByteArray &code, const QString &chunkName);
+
+    // Enable or disable use of the on-disk chunk cache (enabled by default).
+    static void setCacheEnabled( bool);
+    static bool isCacheEnabled();
+
+private:
+    static bool _useCache;
+};  // end class
+
+}   // end namespace
+
+#endif
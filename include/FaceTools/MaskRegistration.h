@@ -21,6 +21,7 @@
 #include "FaceTypes.h"
 #include <r3d/KDTree.h>
 #include <QReadWriteLock>
+#include <QTemporaryDir>
 
 namespace FaceTools {
 
@@ -31,7 +32,9 @@ public:
     // OR if the mask is already loaded because the given path already points to the mask.
     // Calling this function with a filepath that is different to the current mask (even
     // if the given path isn't valid) will call unsetMask to unload any existing mask.
-    static bool setMask( const QString&);
+    // If async is false, the mask is loaded in the calling thread and this function
+    // only returns true if the mask was loaded successfully (useful for headless clients).
+    static bool setMask( const QString&, bool async=true);
 
     // If a mask is already set, this unloads it.
     static void unsetMask();
@@ -64,7 +67,7 @@ public:
         std::unordered_map<int, std::pair<int, Vec3f> > lmksM;
         std::unordered_map<int, std::pair<int, Vec3f> > lmksR;
 
-        std::unordered_map<int, int> oppVtxs;  // Map of laterally opposite vertex IDs
+        std::vector<int> oppVtxs;  // Laterally opposite vertex IDs indexed by (sequential) mask vertex ID
         IntSet medialVtxs;      // Medial (centreline) vertices
         IntSet q0, q1, q2, q3;  // Quadrant vertices (top left, top right, bottom right, bottom left)
         Vec3f centre;   // Centre taken from just the medial vertices
@@ -79,7 +82,18 @@ public:
 
     // Register the currently set mask against the given model and return it.
     // The model must have first been brought into *reasonable* rigid alignment with the mask.
-    static r3d::Mesh::Ptr registerMask( const r3d::KDTree &target);
+    // If multires is true, registration is first done against a version of the target subsampled
+    // to voxels of size COARSE_VOXEL_SCALE * mask radius before a few iterations at full density.
+    // Set multires false to register only at full density (slower, but a reference for accuracy).
+    // Returns null if the work on the calling thread is cancelled (checked between stages).
+    static r3d::Mesh::Ptr registerMask( const r3d::KDTree &target, bool multires=true);
+
+    // Returns the mean distance from the vertices of a registered mask to their
+    // closest points on the target's surface (not just the closest target vertices).
+    static float registrationError( const r3d::Mesh &mask, const r3d::KDTree &target);
+
+    // Voxel size (as a proportion of the mask radius) of the coarse target used if multires.
+    static const float COARSE_VOXEL_SCALE;
 
     // Given a deformed version of the loaded mask, run procrustes superimposition
     // on it and return its transform from the currently loaded mask.
@@ -88,6 +102,7 @@ public:
 private:
     static MaskData s_mask;
     static QReadWriteLock s_lock;
+    static void _loadMask( const QString&, const QString&, QTemporaryDir*, FM*);
 };  // end class
 
 }   // end namespace
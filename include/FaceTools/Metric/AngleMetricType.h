@@ -45,16 +45,16 @@ public:
 
     Vis::MetricVisualiser* visualiser() override { return &_vis;}
 
-    bool hasMeasurement( const FM *fm) const override { return _angleInfo.count(fm) > 0;}
+    bool hasMeasurement( const FM *fm) const override { return _angleInfo.has(fm);}
     void purge( const FM *fm) override { _angleInfo.erase(fm);}
-    const std::vector<AngleMeasure> &angleInfo( const FM *fm) const { return _angleInfo.at(fm);}
+    std::vector<AngleMeasure> angleInfo( const FM *fm) const { return _angleInfo.at(fm);}
 
 protected:
     float update( size_t, const FM*, const std::vector<Vec3f>&, Vec3f, Vec3f, bool, bool) override;
 
 private:
     Vis::AngleVisualiser _vis;
-    std::unordered_map<const FM*, std::vector<AngleMeasure> > _angleInfo;
+    MeasureCache<AngleMeasure> _angleInfo;
 };  // end class
 
 }}   // end namespaces
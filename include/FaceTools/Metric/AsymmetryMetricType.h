@@ -42,16 +42,16 @@ public:
 
     Vis::MetricVisualiser* visualiser() override { return &_vis;}
 
-    bool hasMeasurement( const FM *fm) const override { return _asymmInfo.count(fm) > 0;}
+    bool hasMeasurement( const FM *fm) const override { return _asymmInfo.has(fm);}
     void purge( const FM *fm) override { _asymmInfo.erase(fm);}
-    const std::vector<AsymmetryMeasure> &asymmetryInfo( const FM *fm) const { return _asymmInfo.at(fm);}
+    std::vector<AsymmetryMeasure> asymmetryInfo( const FM *fm) const { return _asymmInfo.at(fm);}
 
 protected:
     float update( size_t, const FM*, const std::vector<Vec3f>&, Vec3f, Vec3f, bool, bool) override;
 
 private:
     Vis::AsymmetryVisualiser _vis;
-    std::unordered_map<const FM*, std::vector<AsymmetryMeasure> > _asymmInfo;
+    MeasureCache<AsymmetryMeasure> _asymmInfo;
 };  // end class
 
 }}   // end namespaces
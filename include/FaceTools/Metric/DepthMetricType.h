@@ -42,17 +42,17 @@ public:
 
     bool fixedInPlane() const override { return false;}
 
-    bool hasMeasurement( const FM *fm) const override { return _depthInfo.count(fm) > 0;}
+    bool hasMeasurement( const FM *fm) const override { return _depthInfo.has(fm);}
     void purge( const FM *fm) override { _depthInfo.erase(fm);}
 
-    const std::vector<DepthMeasure> &depthInfo( const FM *fm) const { return _depthInfo.at(fm);}
+    std::vector<DepthMeasure> depthInfo( const FM *fm) const { return _depthInfo.at(fm);}
 
 protected:
     float update( size_t, const FM*, const std::vector<Vec3f>&, Vec3f, Vec3f, bool, bool) override;
 
 private:
     Vis::DepthVisualiser _vis;
-    std::unordered_map<const FM*, std::vector<DepthMeasure> > _depthInfo;
+    MeasureCache<DepthMeasure> _depthInfo;
 };  // end class
 
 }}   // end namespaces
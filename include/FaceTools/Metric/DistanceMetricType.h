@@ -42,17 +42,17 @@ public:
 
     bool fixedInPlane() const override { return false;}
 
-    bool hasMeasurement( const FM *fm) const override { return _distInfo.count(fm) > 0;}
+    bool hasMeasurement( const FM *fm) const override { return _distInfo.has(fm);}
     void purge( const FM *fm) override { _distInfo.erase(fm);}
 
-    const std::vector<DistMeasure> &distInfo( const FM *fm) const { return _distInfo.at(fm);}
+    std::vector<DistMeasure> distInfo( const FM *fm) const { return _distInfo.at(fm);}
 
 protected:
     float update( size_t, const FM*, const std::vector<Vec3f>&, Vec3f, Vec3f, bool, bool) override;
 
 private:
     Vis::DistanceVisualiser _vis;
-    std::unordered_map<const FM*, std::vector<DistMeasure> > _distInfo;
+    MeasureCache<DistMeasure> _distInfo;
 };  // end class
 
 }}   // end namespaces
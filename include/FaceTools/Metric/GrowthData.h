@@ -20,6 +20,7 @@
 
 #include <FaceTools/FaceTypes.h>
 #include <rlib/RangedScalarDistribution.h>
+#include <mutex>
 
 namespace FaceTools { namespace Metric {
 
@@ -71,6 +72,17 @@ public:
     // all of the dimensions of the statistics.
     bool isWithinAgeRange( float age) const;
 
+    // Return the mean, or the z-score of value v, at the given age for dimension d. Ages are
+    // clamped to the domain of the distribution and values are interpolated from tables
+    // sampled from the distribution at monthly intervals. Returns zero if dimension d has
+    // no distribution.
+    float mean( float age, size_t d=0) const;
+    float zscore( float age, float v, size_t d=0) const;
+
+    // Sample the distributions into the lookup tables (otherwise done on first lookup).
+    // Distributions should not be changed after this. Thread safe.
+    void prepareLookups() const;
+
     ~GrowthData();  // Public for Lua
 
 private:
@@ -83,6 +95,18 @@ private:
     QString _source, _note, _lnote;
     std::vector<rlib::RSD::Ptr> _rsds;
 
+    struct Lookup
+    {
+        float t0, t1;   // Age domain
+        float scale;    // Samples per year
+        std::vector<float> means, sds;
+    };  // end struct
+
+    mutable std::vector<Lookup> _lookups;
+    mutable std::once_flag _lookupsOnce;
+    void _makeLookups() const;
+    bool _lookup( float, size_t, float&, float&) const;
+
     static Ptr create( int, size_t, int8_t, int, bool);
     GrowthData( int, size_t, int8_t, int, bool);
     GrowthData( const GrowthData&) = delete;
@@ -19,6 +19,9 @@
 #define FACE_TOOLS_METRIC_GROWTH_DATA_RANKER_H
 
 #include "GrowthData.h"
+#include <QMutex>
+#include <map>
+#include <tuple>
 
 namespace FaceTools { namespace Metric {
 
@@ -44,6 +47,11 @@ public:
     // Return the compatible set for the given sex and ethnicity.
     GrowthDataSources compatible( int8_t sex, int ethn) const;
 
+    // Return the best match from the compatible set for the given model. Same as
+    // bestMatch( compatible( fm), fm) but memoised by the model's sex, ethnicities
+    // and the set of growth data covering its age. Thread safe.
+    const GrowthData* bestMatch( const FM*) const;
+
     // Return the matching GrowthData or null.
     const GrowthData* matching( int8_t sex, int ethn, const QString& src) const;
 
@@ -62,6 +70,19 @@ private:
     std::unordered_set<GrowthData::Ptr> _allptrs;
     std::unordered_map<int, const GrowthData*> _stats;
 
+    // Sorted distinct age range bounds of all growth data. The set of growth data within age
+    // range is the same for all ages in the same interval between (or at) these bounds.
+    std::vector<double> _ageBounds;
+    int _ageKey( float) const;
+
+    // Memoised compatible sets by sex and ethnicity and best matches by demographic.
+    using DemographicKey = std::tuple<int8_t, int, int, int>;   // Sex, ethnicities, age key
+    mutable QMutex _mutex;
+    mutable std::unordered_map<int8_t, std::unordered_map<int, GrowthDataSources> > _ecompat;
+    mutable std::map<DemographicKey, const GrowthData*> _bestMatches;
+    void _clearMemos();
+
+    GrowthDataSources _compatible( int8_t, int, int, float) const;
     GrowthDataSources _compatible( int8_t, int) const;
     void _compatible( int8_t, int, GrowthDataSources&) const;
 
@@ -92,6 +92,16 @@ private:
     // Returns whether or not the measurement was changed.
     bool _measure( FM*) const;
 
+    // Calculate this metric's values for the given model's current assessment without
+    // setting them. Reentrant so different metrics can be calculated concurrently
+    // for the same model (which is only read from).
+    using SideValues = std::vector<std::pair<FaceSide, MetricValue> >;
+    void _calculate( const FM*, SideValues&) const;
+
+    // Set previously calculated values on the model's current assessment
+    // returning whether or not any of the measurements were changed.
+    bool _setValues( FM*, const SideValues&) const;
+
     // Returns true iff this metric can be measured for the given model's current assessment.
     bool _canMeasure( const FM*) const;
 
@@ -21,6 +21,7 @@
 #include <FaceTools/Vis/MetricVisualiser.h>
 #include <FaceTools/LndMrk/LandmarkSet.h>
 #include <FaceTools/FaceModel.h>
+#include <QMutex>
 
 namespace FaceTools { namespace Metric {
 
@@ -41,6 +42,62 @@ struct FaceTools_EXPORT MetricParams
 };  // end MetricParams
 
 
+// Per-model cache of the data a metric type records when measuring (for visualisation).
+// Each model has its own context with its own lock so measuring one model never waits
+// on another. The cache's lock is held only to find (or create) a model's context.
+// Readers get a copy of a model's measures since measuring may resize them concurrently.
+template <typename M>
+class MeasureCache
+{
+public:
+    bool has( const FM *fm) const { QMutexLocker lock(&_mutex); return _ctxs.count(fm) > 0;}
+
+    // Returns a copy of the measures for the given model (empty if none).
+    std::vector<M> at( const FM *fm) const
+    {
+        const std::shared_ptr<Context> ctx = _context( fm);
+        if ( !ctx)
+            return std::vector<M>();
+        QMutexLocker lock( &ctx->mutex);
+        return ctx->info;
+    }   // end at
+
+    // Set the measure for dimension k of the given model.
+    void set( const FM *fm, size_t k, const M &m)
+    {
+        const std::shared_ptr<Context> ctx = _context( fm, true);
+        QMutexLocker lock( &ctx->mutex);
+        ctx->info.resize( std::max( ctx->info.size(), k+1));
+        ctx->info[k] = m;
+    }   // end set
+
+    void erase( const FM *fm) { QMutexLocker lock(&_mutex); _ctxs.erase(fm);}
+
+private:
+    struct Context
+    {
+        QMutex mutex;
+        std::vector<M> info;
+    };  // end struct
+
+    mutable QMutex _mutex;
+    mutable std::unordered_map<const FM*, std::shared_ptr<Context> > _ctxs;
+
+    std::shared_ptr<Context> _context( const FM *fm, bool create=false) const
+    {
+        QMutexLocker lock(&_mutex);
+        auto it = _ctxs.find(fm);
+        if ( it != _ctxs.end())
+            return it->second;
+        if ( !create)
+            return nullptr;
+        std::shared_ptr<Context> ctx = std::make_shared<Context>();
+        _ctxs[fm] = ctx;
+        return ctx;
+    }   // end _context
+};  // end class
+
+
 class FaceTools_EXPORT MetricType
 {
 public:
@@ -75,6 +132,7 @@ public:
     // Measure against the given model for its current assessment. Output values are placed
     // into out parameter results with as many entries as there are measurement dimensions.
     // The inPlane option is only considered if this metric is not fixedInPlane().
+    // Reentrant for different models (the model itself is only read from).
     void measure( std::vector<float> &results, const FM*, bool swapSide, bool inPlane);
 
     // Get this list of points for dimension i. Use swapped=true if this is a bilateral metric
@@ -90,7 +148,7 @@ public:
 protected:
     // From the given model and points, projection plane vector, and flag saying whether or not to
     // project (ignored if fixedInPlane()), calculate and return the measurement value for dimension
-    // dim. Child classes should update cache of measurements for the given model if need be. If
+    // dim. Child classes should update their MeasureCache for the given model if need be. If
     // swapped is true, then this is a bilateral metric and the measurement needed is for the other
     // side of the face.
     virtual float update( size_t dim, const FM*, const std::vector<Vec3f>&, Vec3f, Vec3f, bool, bool) = 0;
@@ -19,8 +19,9 @@
 #define FACE_TOOLS_METRIC_PHENOTYPE_H
 
 #include <FaceTools/FaceTypes.h>
-#include "MetricSet.h"
+#include "PhenotypeExpression.h"
 #include <sol.hpp>
+#include <QMutex>
 
 namespace FaceTools { namespace Metric {
 
@@ -29,8 +30,10 @@ class FaceTools_EXPORT Phenotype
 public:
     using Ptr = std::shared_ptr<Phenotype>;
 
-    // Load from lua script returning null on error.
-    static Ptr load( const QString&);
+    // Load from lua script returning null on error. The determination function is compiled
+    // to a native PhenotypeExpression if possible and only run through Lua otherwise (or
+    // always through Lua if compile is false).
+    static Ptr load( const QString&, bool compile=true);
 
     // Create a new empty Phenotype object.
     static Ptr create();
@@ -90,9 +93,14 @@ public:
      * Check if this phenotypic indication is present given the measurements
      * recorded in the metric sets of the provided model and the assessment
      * data (landmarks). Uses the currently set assessment if assessId = -1.
-     * Ignores demographic data about the model.
+     * Ignores demographic data about the model. If given, zs points to the z-scores of
+     * the assessment's medial, left and right metric sets at the model's age (see
+     * StatsManager::zscores) for use by compiled determination functions.
      */
-    bool isPresent( const FM&, int assessId=-1) const;
+    bool isPresent( const FM&, int assessId=-1, const StatsManager::LateralZScores *zs=nullptr) const;
+
+    // Returns true iff the determination function was compiled (so is evaluated without Lua).
+    bool isCompiled() const { return _expr != nullptr;}
 
     ~Phenotype(){}  // Public for Lua
 
@@ -106,8 +114,12 @@ private:
     QString _remarks;
     QStringList _refs;
     IntSet _metrics;
-    sol::state _lua;
+    PhenotypeExpression::Ptr _expr;
+    std::unique_ptr<sol::state> _lua;   // Only for determination functions that couldn't be compiled
     sol::function _determine;
+    mutable QMutex _luaMutex;
+
+    bool _loadLua( const QString&);
 
     /**
      * Returns true iff the given model has measurements for all of the
@@ -0,0 +1,69 @@
+/************************************************************************
+ * Copyright (C) 2021 SIS Research Ltd & Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#ifndef FACE_TOOLS_METRIC_PHENOTYPE_EXPRESSION_H
+#define FACE_TOOLS_METRIC_PHENOTYPE_EXPRESSION_H
+
+#include "StatsManager.h"
+
+namespace FaceTools { namespace Metric {
+
+/**
+ * Native form of a phenotype determination function. Compiles the Lua source of functions
+ * with the form "function( age, mlat, llat, rlat) return <expr> end" where the expression
+ * uses the arithmetic, relational and logical operators, numeric literals, math.abs/min/max/sqrt
+ * and the zscore, mean, value and ndims queries on the metrics in the three lateral sets.
+ * Anything else (local variables, branching, other functions) isn't compiled and the
+ * caller should fall back to calling the function through Lua.
+ */
+class FaceTools_EXPORT PhenotypeExpression
+{
+public:
+    using Ptr = std::shared_ptr<const PhenotypeExpression>;
+
+    // Compile the given function source returning null if it can't be compiled
+    // (with the reason in err if given).
+    static Ptr compile( const QString &fnsrc, QString *err=nullptr);
+
+    // Evaluate with Lua's semantics against the given age and metric sets for the medial,
+    // left and right laterals. Returns false if a referenced measurement is missing.
+    // If given, zs points to the z-scores of the three sets at the given age (as returned by
+    // StatsManager::zscores for each) which are used rather than looking up the stats for each query.
+    // Reentrant so may be evaluated concurrently.
+    bool evaluate( float age, const MetricSet &mlat, const MetricSet &llat, const MetricSet &rlat,
+                   const StatsManager::LateralZScores *zs=nullptr) const;
+
+    // Returns the ids of the metrics referenced by the expression.
+    const IntSet &metrics() const { return _mids;}
+
+    ~PhenotypeExpression();
+
+private:
+    struct Node;
+    class Parser;
+    std::vector<Node> _nodes;
+    int _root;
+    IntSet _mids;
+    bool _eval( int, float, const MetricSet*[3], const StatsManager::LateralZScores*, double&) const;
+    PhenotypeExpression();
+    PhenotypeExpression( const PhenotypeExpression&) = delete;
+    void operator=( const PhenotypeExpression&) = delete;
+};  // end class
+
+}}   // end namespaces
+
+#endif
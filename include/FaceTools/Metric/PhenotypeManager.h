@@ -68,6 +68,10 @@ public:
     // corresponding to each phenotypic indication.
     static IntSet discover( const FM&, int aid=-1);
 
+    // Given the set of IDs previously discovered for the model and assessment, re-check only
+    // those phenotypic indications that depend upon the given metrics and return the updated set.
+    static IntSet rediscover( const FM&, const IntSet &dids, const IntSet &mids, int aid=-1);
+
 private:
     static IntSet _ids;
     static QStringList _names;                             // Phenotype names
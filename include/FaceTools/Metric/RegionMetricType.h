@@ -41,16 +41,16 @@ public:
 
     bool fixedInPlane() const override { return false;}
 
-    bool hasMeasurement( const FM *fm) const override { return _regionInfo.count(fm) > 0;}
+    bool hasMeasurement( const FM *fm) const override { return _regionInfo.has(fm);}
     void purge( const FM *fm) override { _regionInfo.erase(fm);}
-    const std::vector<RegionMeasure> &regionInfo( const FM *fm) const { return _regionInfo.at(fm);}
+    std::vector<RegionMeasure> regionInfo( const FM *fm) const { return _regionInfo.at(fm);}
 
 protected:
     float update( size_t, const FM*, const std::vector<Vec3f>&, Vec3f, Vec3f, bool, bool) override;
 
 private:
     Vis::RegionVisualiser _vis;
-    std::unordered_map<const FM*, std::vector<RegionMeasure> > _regionInfo;
+    MeasureCache<RegionMeasure> _regionInfo;
 };  // end class
 
 }}   // end namespaces
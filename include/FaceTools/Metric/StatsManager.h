@@ -19,7 +19,9 @@
 #define FACE_TOOLS_METRIC_STATS_MANAGER_H
 
 #include "GrowthData.h"
+#include "MetricSet.h"
 #include <FaceTools/FaceModel.h>
+#include <array>
 
 namespace FaceTools { namespace Metric {
 
@@ -34,6 +36,15 @@ public:
     // Returned pointer holds a read lock on this class until destroyed.
     static RPtr stats( int mid, const FM*);
 
+    // Return the z-scores at the given age for every dimension of every metric in the given set
+    // using the stats for the given model (as set by updateStatsForModel). Takes the lock once for
+    // all metrics rather than for every lookup. Metrics without stats get z-scores of zero.
+    using ZScores = std::unordered_map<int, std::vector<float> >;
+    static ZScores zscores( const FM*, const MetricSet&, float age);
+
+    // The z-scores of an assessment's medial, left and right metric sets (in that order).
+    using LateralZScores = std::array<ZScores, 3>;
+
     // Update the stats to use for the given model - automatically choosing the best for it.
     // Can call from a separate thread since might take a few moments.
     static void updateStatsForModel( const FM&);
@@ -89,7 +89,14 @@ public:
 
     static Vis::FV* selectedView();
     static bool isViewSelected() { return selectedView() != nullptr;}
-    static FM* selectedModel() { return selectedView() ? selectedView()->data() : nullptr;}
+    static FM* selectedModel();
+
+    // Bind the model returned by selectedModel (and the scoped lock functions below) for the
+    // calling thread only, so that asynchronous work acts on the model that was selected when
+    // it was scheduled regardless of later selection changes. The GUI thread also binds models
+    // while executing coalesced actions for models that may not be selected, and while finishing
+    // asynchronous actions. Pass null to unbind. Returns the previously bound model.
+    static FM* bindModel( FM*);
 
     // Return pointer to the other (non-selected) model if it exists.
     static FM* nonSelectedModel();
@@ -0,0 +1,90 @@
+/************************************************************************
+ * Copyright (C) 2021 SIS Research Ltd & Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+
+#ifndef FACE_TOOLS_SURFACE_DATA_ARCHIVE_H
+#define FACE_TOOLS_SURFACE_DATA_ARCHIVE_H
+
+/**
+ * Per-vertex surface data arrays (curvature and symmetry maps) persisted inside 3DF archives.
+ * Arrays are written tagged with a hash of the content of the mesh they were calculated over.
+ * On reading, arrays with a matching tag are held here against the model until the owning store
+ * claims them in place of recalculating. Claiming only succeeds while the model's mesh content
+ * still matches that when the arrays were set, so stale data are never handed out.
+ *
+ * Binary layout (version 1, little-endian):
+ *   char[4]  magic "R3DS"
+ *   uint32   version
+ *   uint64   mesh content hash
+ *   uint32   #arrays A, then for each array:
+ *     uint32   #bytes B, then B bytes of the array name (UTF-8)
+ *     uint32   #components C
+ *     uint32   #tuples T, then T x C float32
+ */
+
+#include "FaceTypes.h"
+#include <vtkFloatArray.h>
+#include <r3d/Mesh.h>
+#include <QMutex>
+
+namespace FaceTools {
+
+class FaceTools_EXPORT SurfaceDataArchive
+{
+public:
+    using Arrays = std::vector<vtkSmartPointer<vtkFloatArray> >;
+
+    // Set whether surface data are written into archives (true by default).
+    static void setEnabled( bool);
+    static bool isEnabled();
+
+    // Hash of the mesh's transformed vertex positions and face topology.
+    // Zero is returned for meshes without sequential vertex and face IDs.
+    static size_t meshHash( const r3d::Mesh&);
+
+    // Write/read the given named arrays and content hash to/from the given stream returning true on success.
+    // Reading fails if any array doesn't have the expected number of tuples (e.g. the number of vertices
+    // of the mesh the arrays are for) or if the stream is too short for the sizes given in it.
+    static bool write( const Arrays&, size_t hash, std::ostream&);
+    static bool read( std::istream&, Arrays&, size_t &hash, size_t ntuples);
+
+    // Hold the given arrays for the named store against the model. The hash should describe the
+    // model's current state (as the store would calculate it when claiming). Replaces any existing.
+    static void set( const FM*, const QString &store, size_t hash, const Arrays&);
+
+    // Claim (removing) the arrays held for the named store against the model returning
+    // true iff they were set with the given hash. Arrays set with a different hash are discarded.
+    static bool take( const FM*, const QString &store, size_t hash, Arrays&);
+
+    // Discard all arrays held against the given model.
+    static void purge( const FM*);
+
+private:
+    struct Held
+    {
+        size_t hash;
+        Arrays arrays;
+    };  // end struct
+
+    static std::unordered_map<const FM*, std::unordered_map<QString, Held> > _held;
+    static bool _enabled;
+    static QMutex _lock;
+};  // end class
+
+}   // end namespace
+
+#endif
@@ -0,0 +1,138 @@
+/************************************************************************
+ * Copyright (C) 2021 SIS Research Ltd & Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#ifndef FACE_TOOLS_SURFACE_DATA_BUDGET_H
+#define FACE_TOOLS_SURFACE_DATA_BUDGET_H
+
+/**
+ * Shared memory budget for the per-model surface data stores (curvature, delta and symmetry).
+ * Stores record the approximate size of each entry they hold and touch entries when they're
+ * accessed. When total usage exceeds the budget, the least recently used entries are evicted
+ * through the evictor the owning store registered. When an evicted entry is next requested,
+ * the store returns null and asks for it to be recalculated through the recalculator set for
+ * the store (see setRecalculator) which is expected to do so asynchronously. Entries are only
+ * evicted from stores having a recalculator.
+ */
+
+#include "FaceTypes.h"
+#include <vtkDataArray.h>
+#include <r3d/Mesh.h>
+#include <QReadWriteLock>
+#include <QStringList>
+#include <QMutex>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <tuple>
+
+namespace FaceTools {
+
+class FaceTools_EXPORT SurfaceDataBudget
+{
+public:
+    // Evictors are called without the budget lock held and should release the entry returning true.
+    // If the entry can't be released (because it's in use), false should be returned in which case
+    // the entry is kept as the most recently used.
+    using Evictor = std::function<bool( const FM*, const FM*)>;
+
+    // Register a store with the given name and evictor returning its id.
+    static int addStore( const QString &name, const Evictor&);
+
+    // Recalculators are called (from any thread) to have the given entry recalculated
+    // by some other means. They should return straight away and not call back into the store.
+    using Recalculator = std::function<void( const FM*, const FM*)>;
+
+    // Set the recalculator for the named store. May be called before the store is added.
+    static void setRecalculator( const QString &name, const Recalculator&);
+
+    // Called by stores to request the recalculation of an evicted entry.
+    static void recalculate( int store, const FM*, const FM*);
+
+    // Set the budget in bytes (1GB by default). Zero means unlimited. Setting a
+    // lower budget than current usage causes immediate eviction.
+    static void setBudget( size_t);
+    static size_t budget();
+
+    // Returns the total number of bytes held across all stores, or by just the given store.
+    static size_t usage();
+    static size_t usage( int store);
+
+    // Returns the number of entries held across all stores.
+    static size_t count();
+
+    // Returns the names of the registered stores (indexed by store id).
+    static QStringList storeNames();
+
+    // Returns the number of entries evicted since startup.
+    static size_t evictions();
+
+    // Record an entry of the given size (replacing any existing) as most recently used,
+    // evicting the least recently used entries of any store if over budget.
+    // The second model is only used by stores with entries for pairs of models.
+    static void add( int store, const FM*, const FM*, size_t bytes);
+
+    // Mark an existing entry as most recently used.
+    static void touch( int store, const FM*, const FM*);
+
+    // Stop tracking an entry (on the owning store purging it).
+    static void remove( int store, const FM*, const FM*);
+
+    // Estimates of memory used by data arrays and meshes (VTK's GetActualMemorySize isn't const).
+    static size_t bytes( vtkDataArray*);
+    static size_t bytes( const r3d::Mesh&);
+
+private:
+    struct Entry
+    {
+        int store;
+        const FM *fm0;
+        const FM *fm1;
+        size_t bytes;
+    };  // end struct
+
+    using Key = std::tuple<int, const FM*, const FM*>;
+    static std::list<Entry> _lru;   // Most recently used at front
+    static std::map<Key, std::list<Entry>::iterator> _entries;
+    static std::vector<std::pair<QString, Evictor> > _stores;
+    static std::unordered_map<QString, Recalculator> _recalcs;   // Keyed by store name
+    static std::vector<size_t> _usage;  // Per store
+    static size_t _total;
+    static size_t _budget;
+    static size_t _nevicted;
+    static QMutex _lock;
+    static void _evict();
+};  // end class
+
+
+// Surface data store entry having its own lock so that reading or writing
+// the data of one model (or pair of models) never blocks access to another's.
+template <typename T>
+struct SurfaceDataEntry
+{
+    using Ptr = std::shared_ptr<SurfaceDataEntry<T> >;
+    static Ptr create( const std::shared_ptr<T> &d) { return Ptr( new SurfaceDataEntry<T>(d));}
+
+    std::shared_ptr<T> data;
+    QReadWriteLock lock;
+
+private:
+    explicit SurfaceDataEntry( const std::shared_ptr<T> &d) : data(d) {}
+};  // end struct
+
+}   // end namespace
+
+#endif
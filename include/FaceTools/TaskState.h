@@ -0,0 +1,87 @@
+/************************************************************************
+ * Copyright (C) 2021 SIS Research Ltd & Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+
+#ifndef FACE_TOOLS_TASK_STATE_H
+#define FACE_TOOLS_TASK_STATE_H
+
+/**
+ * Cooperative cancellation and progress reporting for long running work. Work checks for
+ * cancellation at convenient points (per block of vertices, per hole filled, per registration
+ * stage etc) and returns early without publishing partial results if it's been cancelled.
+ * Progress is counted in steps: work adds the number of steps it will take and advances
+ * them as it goes. The state for the work running on a thread is set as that thread's
+ * current state so that kernels several calls deep needn't have it passed in.
+ */
+
+#include "FaceTypes.h"
+#include <atomic>
+
+namespace FaceTools {
+
+class FaceTools_EXPORT TaskState
+{
+public:
+    using Ptr = std::shared_ptr<TaskState>;
+    static Ptr create();
+
+    // Request that the work stops (at its next check).
+    void cancel() { _cancelled = true;}
+    bool isCancelled() const { return _cancelled;}
+
+    // Add to the total number of steps of the work.
+    void addSteps( size_t n) { _nsteps += n;}
+
+    // Mark steps of the work done.
+    void advance( size_t n=1) { _ndone += n;}
+
+    // Fraction of the work done in [0,1] or zero if no steps added.
+    float progress() const;
+
+    // For loops over n indices having added n steps: call for every index i returning true iff
+    // the loop should return early because of cancellation. Steps are advanced in blocks of 256
+    // indices so advance( n % 256) should be called once after the loop.
+    bool poll( size_t i)
+    {
+        if ( _cancelled)
+            return true;
+        if ( (i & 0xff) == 0xff)
+            _ndone += 0x100;
+        return false;
+    }   // end poll
+
+    // The state for the work on the calling thread (null if none).
+    static TaskState* current();
+
+    // Set the state for the work on the calling thread returning the previous.
+    static TaskState* setCurrent( TaskState*);
+
+    // True iff work on the calling thread has a state and it's been cancelled.
+    static bool cancelled() { const TaskState *ts = current(); return ts && ts->isCancelled();}
+
+private:
+    std::atomic<bool> _cancelled;
+    std::atomic<size_t> _nsteps;
+    std::atomic<size_t> _ndone;
+    TaskState();
+    TaskState( const TaskState&) = delete;
+    void operator=( const TaskState&) = delete;
+};  // end class
+
+}   // end namespace
+
+#endif
@@ -0,0 +1,106 @@
+/************************************************************************
+ * Copyright (C) 2021 SIS Research Ltd & Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+
+#ifndef FACE_TOOLS_TRACE_H
+#define FACE_TOOLS_TRACE_H
+
+/**
+ * Lightweight scoped timing of actions and kernels for attributing latency within a session.
+ * Tracing is off by default in which case a Scope costs a single flag check. When on, each
+ * Scope records a complete event (start and duration in microseconds) against the calling
+ * thread into a bounded buffer (oldest events dropped first). The buffer can be written out
+ * in the Chrome trace event JSON format for loading into chrome://tracing or Perfetto.
+ * The facebatch and facebench tools enable tracing and write it out with --trace <file>.
+ */
+
+#include "FaceTypes.h"
+#include <QMutex>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+
+namespace FaceTools {
+
+class FaceTools_EXPORT Trace
+{
+public:
+    // Set whether events are recorded (false by default).
+    static void setEnabled( bool v) { _enabled = v;}
+    static bool isEnabled() { return _enabled;}
+
+    // Set the maximum number of events held (default 200000).
+    static void setCapacity( size_t);
+
+    // Microseconds since the trace clock's origin.
+    static int64_t now();
+
+    // Record an asynchronous span from t0 (as returned by now()) to now. Use for work that
+    // starts and finishes on different threads; id distinguishes concurrent spans of the same name.
+    static void addSpan( const char *cat, const std::string &name, uintptr_t id, int64_t t0);
+
+    // Write the held events to the given file in Chrome trace event format returning true on success.
+    static bool write( const QString &fpath);
+
+    // Discard all held events.
+    static void clear();
+
+    // Times its own lifetime. Name and detail are copied only when tracing is on.
+    class FaceTools_EXPORT Scope
+    {
+    public:
+        Scope( const char *cat, const char *name, const char *detail=nullptr);
+        Scope( const char *cat, const std::string &name, const char *detail=nullptr);
+        Scope( const char *cat, const char *name, const QString &detail);
+        ~Scope();
+
+    private:
+        const char *_cat;
+        std::string _name;
+        std::string _detail;
+        int64_t _t0;
+        bool _on;
+        Scope( const Scope&) = delete;
+        void operator=( const Scope&) = delete;
+    };  // end class
+
+private:
+    struct Record
+    {
+        char ph;            // Chrome trace phase ('X' complete or 'b'/'e' async)
+        const char *cat;
+        std::string name;
+        std::string detail;
+        int64_t ts;
+        int64_t dur;
+        int tid;
+        uintptr_t id;
+    };  // end struct
+
+    static std::atomic<bool> _enabled;
+    static size_t _capacity;
+    static std::deque<Record> _events;
+    static std::unordered_map<int, std::string> _tnames; // Thread names by trace thread ID
+    static QMutex _lock;
+
+    static int _threadId();
+    static void _add( Record&&);
+};  // end class
+
+}   // end namespace
+
+#endif
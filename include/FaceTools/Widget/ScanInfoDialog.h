@@ -40,6 +40,10 @@ public:
 
     void refreshNotableHPOs();
 
+    // Set the metrics updated since the last refresh so the next refresh of the
+    // notable HPO terms need only re-check the terms dependent on these metrics.
+    void setUpdatedMetrics( const IntSet&);
+
 signals:
     void onInfoChanged();
 
@@ -72,6 +76,11 @@ private:
     Ui::ScanInfoDialog *_ui;
     const QString _dialogRootTitle;
     QTools::EventSignaller _focusOutSignaller;
+    const FM *_hfm;     // Model and assessment the discovered HPO terms are for
+    int _haid;
+    IntSet _hids;       // Discovered HPO terms
+    IntSet _umids;      // Metrics updated since the HPO terms were last discovered
+    bool _partial;
     bool _isDifferentToCurrent() const;
     void _checkEnableApply();
 };  // end class
@@ -134,6 +134,8 @@ Event ActionDetectFace::doAfterAction( Event)
         MS::showStatus( QString("Detected face%1.").arg(plusLmks), 5000);
         ev = _ev | Event::CAMERA_CHANGE;
     }   // end if
+    else if ( isCancelled())
+        MS::showStatus( "Detection cancelled.", 5000);
     else
     {
         MS::showStatus( "Detection failed!", 10000);
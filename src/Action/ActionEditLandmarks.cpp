@@ -16,6 +16,7 @@
  ************************************************************************/
 
 #include <Action/ActionEditLandmarks.h>
+#include <Action/ActionUpdateMeasurements.h>
 #include <Interactor/LandmarksHandler.h>
 #include <LndMrk/LandmarksManager.h>
 #include <Metric/MetricManager.h>
@@ -23,6 +24,7 @@
 #include <QApplication>
 #include <rNonRigid.h>
 using FaceTools::Action::ActionEditLandmarks;
+using FaceTools::Action::ActionUpdateMeasurements;
 using FaceTools::Action::FaceAction;
 using FaceTools::Action::Event;
 using FaceTools::Widget::LandmarksDialog;
@@ -199,6 +201,8 @@ void ActionEditLandmarks::_doOnStartedDrag( int lmid, FaceSide lat)
 void ActionEditLandmarks::_doOnFinishedDrag( int lmid, FaceSide lat)
 {
     _ev = Event::LANDMARKS_CHANGE;
+    // Only the metrics dependent on the dragged landmark need remeasuring.
+    ActionUpdateMeasurements::addChangedLandmark( this, MS::selectedModel(), lmid);
 
     /*
     FM *fm = MS::selectedModel();
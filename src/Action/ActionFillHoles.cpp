@@ -95,9 +95,12 @@ void ActionFillHoles::doAction( Event)
     const size_t nm = manfs->count();
     Mesh::Ptr mesh = fm->mesh().deepCopy();
     Manifolds::Ptr nmanfs;
+    TaskState *ts = TaskState::current();
 
-    while ( true)
+    while ( !isCancelled())
     {
+        if ( ts)
+            ts->addSteps( getNumHoles( *manfs));
         HoleFiller hfiller( mesh);
         std::vector<int> mholes(nm);    // Record the number of holes per manifold
 
@@ -113,10 +116,12 @@ void ActionFillHoles::doAction( Event)
             mholes[i] = std::max(0, nbs-1);
 
             int polysAdded = 0;
-            for ( int j = 1; j < nbs; ++j)  // Ignore the first (longest) boundary
+            for ( int j = 1; j < nbs && !isCancelled(); ++j)  // Ignore the first (longest) boundary
             {
                 const std::list<int>& blist = bnds.boundary(j);
                 polysAdded += hfiller.fillHole( blist, mpolys);
+                if ( ts)
+                    ts->advance();
             }   // end for
 #ifndef NDEBUG
             if ( nbs > 1)
@@ -128,8 +133,8 @@ void ActionFillHoles::doAction( Event)
             sumPolysAdded += polysAdded;
         }   // end for
 
-        // If no polygons added, break loop.
-        if ( sumPolysAdded == 0)
+        // If no polygons added (or cancelled), break loop.
+        if ( sumPolysAdded == 0 || isCancelled())
             break;
 
         nmanfs = Manifolds::create( *mesh);
@@ -138,13 +143,19 @@ void ActionFillHoles::doAction( Event)
         manfs = nmanfs.get();
     }   // end while
 
-    fm->update( mesh, true, true);
+    if ( !isCancelled())    // Leave the model as it was if cancelled
+        fm->update( mesh, true, true);
     fm->unlock();
 }   // end doAction
 
 
 Event ActionFillHoles::doAfterAction( Event)
 {
+    if ( isCancelled())
+    {
+        MS::showStatus( "Hole filling cancelled.", 5000);
+        return Event::NONE;
+    }   // end if
     const size_t nh = getNumHoles( MS::selectedModel()->manifolds());
     MS::showStatus( QString("Finished hole filling; %1 hole%2 remain%3.").arg(nh == 0 ? "no" : QString("%1").arg(nh)).arg( nh != 1 ? "s" : "").arg( nh == 1 ? "s" : ""), 5000);
     return Event::MESH_CHANGE;
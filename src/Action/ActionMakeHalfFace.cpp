@@ -181,12 +181,12 @@ void ActionMakeHalfFace::doAction( Event)
 
         for ( int lvidx : *l0)
         {
-            const Vec3f &v = omask.uvtx( oppVtxs.at( lvidx));
+            const Vec3f &v = omask.uvtx( oppVtxs[lvidx]);
             mask->adjustRawVertex( lvidx, -v[0], v[1], v[2]);
         }   // end for
         for ( int lvidx : *l1)
         {
-            const Vec3f &v = omask.uvtx( oppVtxs.at( lvidx));
+            const Vec3f &v = omask.uvtx( oppVtxs[lvidx]);
             mask->adjustRawVertex( lvidx, -v[0], v[1], v[2]);
         }   // end for
 
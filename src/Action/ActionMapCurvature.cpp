@@ -16,8 +16,10 @@
  ************************************************************************/
 
 #include <Action/ActionMapCurvature.h>
+#include <Action/FaceActionManager.h>
 #include <FaceModelCurvatureStore.h>
 using FaceTools::Action::ActionMapCurvature;
+using FaceTools::Action::FaceActionManager;
 using FaceTools::Action::Event;
 using FaceTools::FM;
 using FaceTools::Vis::FV;
@@ -28,6 +30,9 @@ ActionMapCurvature::ActionMapCurvature() : FaceAction( "Map Curvature")
 {
     addPurgeEvent( Event::MESH_CHANGE);
     addTriggerEvent( Event::MESH_CHANGE);
+    // Curvature evicted from the surface data budget is recalculated by this action.
+    SurfaceDataBudget::setRecalculator( FaceModelCurvatureStore::name(), [this]( const FM *fm, const FM*)
+            { FaceActionManager::schedule( this, fm, Event::SURFACE_DATA_CHANGE);});
 #ifdef NDEBUG
     setAsync(true);
 #endif
@@ -16,9 +16,11 @@
  ************************************************************************/
 
 #include <Action/ActionMapDelta.h>
+#include <Action/FaceActionManager.h>
 #include <FaceModelDeltaStore.h>
 #include <FaceModel.h>
 using FaceTools::Action::ActionMapDelta;
+using FaceTools::Action::FaceActionManager;
 using FaceTools::Action::Event;
 using FaceTools::Vis::FV;
 using FaceTools::FM;
@@ -30,6 +32,10 @@ ActionMapDelta::ActionMapDelta() : FaceAction( "Map Delta")
 {
     addTriggerEvent( Event::MESH_CHANGE | Event::MASK_CHANGE | Event::VIEWER_CHANGE);
     addPurgeEvent( Event::MESH_CHANGE | Event::MASK_CHANGE);
+    // Deltas evicted from the surface data budget are recalculated by this action (for the
+    // target model) so long as the source is still the other model when the action executes.
+    SurfaceDataBudget::setRecalculator( FMDS::name(), [this]( const FM *tgt, const FM*)
+            { FaceActionManager::schedule( this, tgt, Event::SURFACE_DATA_CHANGE);});
     setAsync(true);
 }   // end ctor
 
@@ -57,11 +63,12 @@ void ActionMapDelta::doAction( Event e)
     FM::RPtr tgt = MS::selectedModelScopedRead();
     FM::RPtr src = MS::otherModelScopedRead();
     FMDS::add( tgt.get(), src.get());
-    FMDS::add( src.get(), tgt.get());
+    if ( !isCancelled())
+        FMDS::add( src.get(), tgt.get());
 }   // end doAction
 
 
-Event ActionMapDelta::doAfterAction( Event) { return Event::SURFACE_DATA_CHANGE;}
+Event ActionMapDelta::doAfterAction( Event) { return isCancelled() ? Event::NONE : Event::SURFACE_DATA_CHANGE;}
 
 void ActionMapDelta::purge( const FM *fm) { FMDS::purge(fm);}
 
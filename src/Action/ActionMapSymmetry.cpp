@@ -16,10 +16,12 @@
  ************************************************************************/
 
 #include <Action/ActionMapSymmetry.h>
+#include <Action/FaceActionManager.h>
 #include <FaceModelSymmetryStore.h>
 #include <MaskRegistration.h>
 #include <FaceModel.h>
 using FaceTools::Action::ActionMapSymmetry;
+using FaceTools::Action::FaceActionManager;
 using FaceTools::Action::Event;
 using FaceTools::FM;
 using MS = FaceTools::ModelSelect;
@@ -29,6 +31,9 @@ ActionMapSymmetry::ActionMapSymmetry() : FaceAction( "Map Symmetry")
 {
     addPurgeEvent( Event::MESH_CHANGE | Event::MASK_CHANGE);
     addTriggerEvent( Event::MESH_CHANGE | Event::MASK_CHANGE);
+    // Symmetry evicted from the surface data budget is recalculated by this action.
+    SurfaceDataBudget::setRecalculator( FaceModelSymmetryStore::name(), [this]( const FM *fm, const FM*)
+            { FaceActionManager::schedule( this, fm, Event::SURFACE_DATA_CHANGE);});
     setAsync(true);
 }   // end ctor
 
@@ -49,7 +54,7 @@ void ActionMapSymmetry::doAction( Event)
 
 Event ActionMapSymmetry::doAfterAction( Event)
 {
-    return Event::SURFACE_DATA_CHANGE;
+    return isCancelled() ? Event::NONE : Event::SURFACE_DATA_CHANGE;
 }   // end doAfterAction
 
 
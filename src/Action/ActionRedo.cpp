@@ -66,6 +66,9 @@ void ActionRedo::doAction( Event)
 
 Event ActionRedo::doAfterAction( Event)
 {
-    MS::showStatus( QString("Finished redoing '%1'").arg(_rname), 3000);
+    if ( _e == Event::NONE)
+        MS::showStatus( QString("Unable to redo '%1'!").arg(_rname), 5000);
+    else
+        MS::showStatus( QString("Finished redoing '%1'").arg(_rname), 3000);
     return _e;
 }   // end doAfterAction
@@ -74,10 +74,10 @@ void swapMaskLaterals( r3d::Mesh &mask)
 {
     IntSet rset;
     const auto &oppVtxs = FaceTools::MaskRegistration::maskData()->oppVtxs;
-    for ( const std::pair<int,int> &vpair : oppVtxs)
+    const int N = int(oppVtxs.size());
+    for ( int lvidx = 0; lvidx < N; ++lvidx)
     {
-        const int lvidx = vpair.first;
-        const int rvidx = vpair.second;
+        const int rvidx = oppVtxs[lvidx];
         assert( lvidx >= 0 && rvidx >= 0);
         if ( rset.count(lvidx) == 0)
         {
@@ -17,10 +17,12 @@
 
 #include <Action/ActionRestoreSingleLandmark.h>
 #include <Action/ActionRestoreLandmarks.h>
+#include <Action/ActionUpdateMeasurements.h>
 #include <Interactor/LandmarksHandler.h>
 #include <LndMrk/LandmarksManager.h>
 #include <FaceModel.h>
 using FaceTools::Action::ActionRestoreSingleLandmark;
+using FaceTools::Action::ActionUpdateMeasurements;
 using FaceTools::Action::FaceAction;
 using FaceTools::Action::Event;
 using FaceTools::Interactor::LandmarksHandler;
@@ -66,6 +68,7 @@ void ActionRestoreSingleLandmark::doAction( Event)
     ulmks.insert( _lmid);
     FM::WPtr fm = MS::selectedModelScopedWrite();
     ActionRestoreLandmarks::restoreLandmarks( *fm, ulmks);
+    ActionUpdateMeasurements::addChangedLandmark( this, fm.get(), _lmid);
 }   // end doAction
 
 
@@ -16,6 +16,8 @@
  ************************************************************************/
 
 #include <Action/ActionSave.h>
+#include <Action/ActionMapCurvature.h>
+#include <Action/ActionMapSymmetry.h>
 #include <FileIO/FaceModelManager.h>
 #include <QMessageBox>
 #include <cassert>
@@ -33,6 +35,9 @@ ActionSave::ActionSave( const QString& dn, const QIcon& ico, const QKeySequence&
     // Note need to refresh after SAVE since SaveAs will cause this event.
     addRefreshEvent( Event::MODEL_SELECT | Event::MESH_CHANGE | Event::AFFINE_CHANGE | Event::SAVED_MODEL
                    | Event::LANDMARKS_CHANGE | Event::PATHS_CHANGE | Event::METADATA_CHANGE);
+    // Wait for surface maps being calculated so they're written with the model
+    addDependency<ActionMapCurvature>();
+    addDependency<ActionMapSymmetry>();
     setAsync(true);
 }   // end ctor
 
@@ -16,6 +16,8 @@
  ************************************************************************/
 
 #include <Action/ActionSaveAs.h>
+#include <Action/ActionMapCurvature.h>
+#include <Action/ActionMapSymmetry.h>
 #include <FileIO/FaceModelManager.h>
 #include <QFileInfo>
 #include <QMessageBox>
@@ -32,6 +34,9 @@ using QMB = QMessageBox;
 ActionSaveAs::ActionSaveAs( const QString& dn, const QIcon& ico, const QKeySequence& ks)
     : FaceAction( dn, ico, ks), _fdialog(nullptr)
 {
+    // Wait for surface maps being calculated so they're written with the model
+    addDependency<ActionMapCurvature>();
+    addDependency<ActionMapSymmetry>();
     setAsync(true);
 }   // end ctor
 
@@ -361,7 +361,7 @@ bool ActionShowMetrics::_updateText( const FV *fv, int mid)
             {
                 oss << std::right << std::setw(fw);
                 if ( age > 0.0f)
-                    oss << mv->zscore( age, i);
+                    oss << gd->zscore( age, mv->value(i), i);
                 else
                     oss << "----";
             }   // end if
@@ -369,8 +369,8 @@ bool ActionShowMetrics::_updateText( const FV *fv, int mid)
             {
                 if ( age > 0.0f)
                 {
-                    const double zsr = mvr->zscore( age, i);
-                    const double zsl = mvl->zscore( age, i);
+                    const double zsr = gd->zscore( age, mvr->value(i), i);
+                    const double zsl = gd->zscore( age, mvl->value(i), i);
                     const double zsm = 0.5 * (zsl + zsr);
                     oss << std::right << std::setw(fw) << zsr << " (R)"
                                       << std::setw(fw) << zsl << " (L)"
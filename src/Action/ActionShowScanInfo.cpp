@@ -16,13 +16,16 @@
  ************************************************************************/
 
 #include <Action/ActionShowScanInfo.h>
+#include <Action/ActionUpdateMeasurements.h>
 #include <FaceModel.h>
 using FaceTools::Action::ActionShowScanInfo;
+using FaceTools::Action::ActionUpdateMeasurements;
 using FaceTools::Action::ActionUpdateThumbnail;
 using FaceTools::Action::FaceAction;
 using FaceTools::Action::Event;
 using FaceTools::Widget::ScanInfoDialog;
 using FaceTools::FM;
+using FaceTools::IntSet;
 using MS = FaceTools::ModelSelect;
 
 
@@ -64,7 +67,12 @@ bool ActionShowScanInfo::update( Event e)
         _dialog->setThumbnail( _tupdater->thumbnail());
     }   // end else if
     else if ( has( e, Event::METRICS_CHANGE))
+    {
+        IntSet mids;
+        if ( ActionUpdateMeasurements::lastUpdated( fm, mids))
+            _dialog->setUpdatedMetrics( mids);
         _dialog->refreshAssessment();
+    }   // end else if
     return _dialog->isVisible();
 }   // end update
 
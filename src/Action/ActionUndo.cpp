@@ -66,6 +66,9 @@ void ActionUndo::doAction( Event)
 
 Event ActionUndo::doAfterAction( Event)
 {
-    MS::showStatus( QString("Finished undoing '%1'").arg(_rname), 3000);
+    if ( _e == Event::NONE)
+        MS::showStatus( QString("Unable to undo '%1'!").arg(_rname), 5000);
+    else
+        MS::showStatus( QString("Finished undoing '%1'").arg(_rname), 3000);
     return _e;
 }   // end doAfterAction
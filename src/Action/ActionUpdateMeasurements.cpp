@@ -16,14 +16,26 @@
  ************************************************************************/
 
 #include <Action/ActionUpdateMeasurements.h>
+#include <Action/FaceActionManager.h>
 #include <Interactor/LandmarksHandler.h>
 #include <Metric/MetricManager.h>
+#include <FaceTools.h>
+#include <QMutexLocker>
 using FaceTools::Action::ActionUpdateMeasurements;
+using FaceTools::Action::FaceActionManager;
+using FaceTools::Action::FaceAction;
 using FaceTools::Action::Event;
 using FaceTools::FM;
 using MS = FaceTools::ModelSelect;
 using MM = FaceTools::Metric::MetricManager;
 using MC = FaceTools::Metric::Metric;
+using FaceTools::IntSet;
+
+QMutex ActionUpdateMeasurements::_mutex;
+std::unordered_map<const FM*, IntSet> ActionUpdateMeasurements::_changedLmks;
+std::unordered_map<const FM*, std::unordered_set<const FaceAction*> > ActionUpdateMeasurements::_recorders;
+std::unordered_set<const FM*> ActionUpdateMeasurements::_unrecorded;
+std::unordered_map<const FM*, IntSet> ActionUpdateMeasurements::_updatedMids;
 
 
 ActionUpdateMeasurements::ActionUpdateMeasurements() : FaceAction("Update Measurements")
@@ -49,23 +61,134 @@ bool ActionUpdateMeasurements::updateMeasurement( FM *fm , int mid)
 }   // end updateMeasurement
 
 
+IntSet ActionUpdateMeasurements::_updateMeasurements( FM *fm, const IntSet &mids)
+{
+    // Metrics only read from the model while calculating so calculate them all
+    // concurrently before setting the changed values on the model serially.
+    const std::vector<int> vmids( mids.begin(), mids.end());
+    const size_t n = vmids.size();
+    std::vector<MC::SideValues> svals(n);
+    std::vector<char> measured(n, false);  // Not vector<bool> since set concurrently
+    FaceTools::parallelFor( n, [&]( size_t i)
+    {
+        const MC *m = MM::cmetric( vmids[i]);
+        if ( m && m->_canMeasure( fm))
+        {
+            m->_calculate( fm, svals[i]);
+            measured[i] = true;
+        }   // end if
+    }, 1);
+
+    IntSet umids;
+    for ( size_t i = 0; i < n; ++i)
+        if ( measured[i] && MM::cmetric( vmids[i])->_setValues( fm, svals[i]))
+            umids.insert( vmids[i]);
+    return umids;
+}   // end _updateMeasurements
+
+
 bool ActionUpdateMeasurements::updateAllMeasurements( FM *fm)
 {
-    bool updated = false;
-    if ( fm)
-        for ( int mid : MM::ids())
-            updated |= updateMeasurement( fm, mid);
-    return updated;
+    return fm && !_updateMeasurements( fm, MM::ids()).empty();
 }   // end updateAllMeasurements
 
 
+IntSet ActionUpdateMeasurements::updateMeasurementsForLandmarks( FM *fm, const IntSet &lmids)
+{
+    if ( !fm)
+        return IntSet();
+    // Collect first so metrics dependent on several changed landmarks are measured once.
+    IntSet dmids;
+    for ( int lmid : lmids)
+    {
+        const IntSet &lmmids = MM::metricsForLandmark( lmid);
+        dmids.insert( lmmids.begin(), lmmids.end());
+    }   // end for
+    return _updateMeasurements( fm, dmids);
+}   // end updateMeasurementsForLandmarks
+
+
+void ActionUpdateMeasurements::addChangedLandmark( const FaceAction *act, const FM *fm, int lmid)
+{
+    QMutexLocker lock( &_mutex);
+    _changedLmks[fm].insert(lmid);
+    _recorders[fm].insert(act);
+}   // end addChangedLandmark
+
+
+bool ActionUpdateMeasurements::lastUpdated( const FM *fm, IntSet &mids)
+{
+    QMutexLocker lock( &_mutex);
+    const auto it = _updatedMids.find(fm);
+    if ( it == _updatedMids.end())
+        return false;
+    mids = std::move( it->second);
+    _updatedMids.erase(it);
+    return true;
+}   // end lastUpdated
+
+
+void ActionUpdateMeasurements::postInit()
+{
+    connect( FaceActionManager::get(), &FaceActionManager::onRaised, &ActionUpdateMeasurements::_noteRaised);
+}   // end postInit
+
+
+// private static (GUI thread for every event raised)
+void ActionUpdateMeasurements::_noteRaised( const FM *fm, Event e, const FaceAction *sact)
+{
+    if ( !has( e, Event::LANDMARKS_CHANGE))
+        return;
+    QMutexLocker lock( &_mutex);
+    // The change was recorded iff its raiser recorded it (undo/restore, detection etc never do).
+    auto it = _recorders.find(fm);
+    if ( sact && it != _recorders.end() && it->second.erase(sact) > 0)
+        return;
+    _unrecorded.insert(fm);
+}   // end _noteRaised
+
+
+void ActionUpdateMeasurements::purge( const FM *fm)
+{
+    QMutexLocker lock( &_mutex);
+    _changedLmks.erase(fm);
+    _recorders.erase(fm);
+    _unrecorded.erase(fm);
+    _updatedMids.erase(fm);
+}   // end purge
+
+
 bool ActionUpdateMeasurements::doBeforeAction( Event e) { return true;}
 
 
 void ActionUpdateMeasurements::doAction( Event e)
 {
     FM::WPtr fm = MS::selectedModelScopedWrite();
-    updateAllMeasurements( fm.get());
+
+    // Take the set of landmarks known to have changed since the last update. A partial
+    // update is only possible if the landmarks alone changed and all of the changes
+    // were recorded; changes to the statistics can affect every metric.
+    IntSet lmids;
+    _mutex.lock();
+    if ( _changedLmks.count(fm.get()) > 0)
+    {
+        lmids = _changedLmks.at(fm.get());
+        _changedLmks.erase(fm.get());
+    }   // end if
+    const bool unrecorded = _unrecorded.erase(fm.get()) > 0;
+    const bool partial = !lmids.empty() && !unrecorded && !has( e, Event::STATS_CHANGE);
+    if ( !partial)
+        _updatedMids.erase(fm.get());   // Everything is being updated
+    _mutex.unlock();
+
+    if ( partial)
+    {
+        const IntSet mids = updateMeasurementsForLandmarks( fm.get(), lmids);
+        QMutexLocker lock( &_mutex);
+        _updatedMids[fm.get()].insert( mids.begin(), mids.end());   // Merge with any not yet consumed
+    }   // end if
+    else
+        updateAllMeasurements( fm.get());
 }   // end doAction
 
 
@@ -17,6 +17,7 @@
 
 #include <Action/ActionUpdateThumbnail.h>
 #include <Action/ActionOrientCamera.h>
+#include <Action/ActionMapCurvature.h>
 #include <FaceModelCurvatureStore.h>
 #include <Vis/FaceView.h>
 #include <FaceModel.h>
@@ -38,6 +39,7 @@ ActionUpdateThumbnail::ActionUpdateThumbnail( int w, int h)
     : FaceAction("Thumbnail Updater"), _vsz( w,h)
 {
     addTriggerEvent( Event::MESH_CHANGE | Event::LOADED_MODEL);
+    addDependency<ActionMapCurvature>();   // Vertex normals for smooth lighting
     setAsync(true);
 }   // end ctor
 
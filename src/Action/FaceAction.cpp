@@ -17,7 +17,9 @@
 
 #include <Action/FaceAction.h>
 #include <FaceModelViewer.h>
+#include <FileIO/FaceModelManager.h>
 #include <FaceModel.h>
+#include <Trace.h>
 #include <QSignalBlocker>
 #include <QThread>
 #include <algorithm>
@@ -27,6 +29,7 @@ using FaceTools::Action::FaceAction;
 using FaceTools::Action::UndoState;
 using FaceTools::Action::Event;
 using MS = FaceTools::ModelSelect;
+using FMM = FaceTools::FileIO::FaceModelManager;
 //#undef NDEBUG
 
 
@@ -55,6 +58,7 @@ void FaceAction::_pinit()
     _debugName = "\"" + _dname.replace( "\n", " ").remove('&').toStdString() + "\"";
     _mpos = QPoint(-1,-1);
     _isFinalised = false;
+    _tstart = 0;
 }   // end _pinit
 
 
@@ -198,7 +202,14 @@ bool FaceAction::execute( Event e)
     std::cerr << _dbgPrfx << " Starting " << debugName();
 #endif
 
-    if ( !doBeforeAction(e))  // Always in the GUI thread
+    _tstart = Trace::now();
+    bool goAction;
+    {
+        const Trace::Scope trace( "action", debugName(), "doBeforeAction");
+        goAction = doBeforeAction(e);  // Always in the GUI thread
+    }   // end trace scope
+
+    if ( !goAction)
     {
 #ifndef NDEBUG
         std::cerr << " CANCELLED!" << std::endl;
@@ -209,6 +220,7 @@ bool FaceAction::execute( Event e)
     }   // end if
 
     _isWorking = true;
+    _task = TaskState::create();
 
 #ifdef NDEBUG
     static const bool ALLOW_ASYNC = true;
@@ -219,22 +231,30 @@ bool FaceAction::execute( Event e)
     if ( ALLOW_ASYNC && isAsync())
     {
 #ifndef NDEBUG
-        std::cerr << " <<<NEW THREAD>>>" << std::endl;
+        std::cerr << " <<<SCHEDULED>>>" << std::endl;
 #endif
         if ( e == Event::USER)
             _key = MS::lockSelect();
-        FaceActionWorker *worker = new FaceActionWorker( this, e);
-        connect( worker, &FaceActionWorker::onWorkFinished, this, &FaceAction::_endExecute);
-        connect( worker, &FaceActionWorker::finished, worker, &FaceActionWorker::deleteLater);
-        worker->start();   // Asynchronous start
+        FM *fm = MS::selectedModel();
+        FaceActionWorker *worker = new FaceActionWorker( this, e, fm, _task);
+        connect( worker, &FaceActionWorker::onWorkFinished, this, [this, fm]( Event ev){ _endExecute( ev, fm);});
+        connect( worker, &FaceActionWorker::onWorkFinished, worker, &FaceActionWorker::deleteLater);
+        connect( worker, &FaceActionWorker::onWorkDropped, this, &FaceAction::_abortExecute);
+        connect( worker, &FaceActionWorker::onWorkDropped, worker, &FaceActionWorker::deleteLater);
+        FaceActionWorker::schedule( worker);   // Asynchronous start (when dependencies allow)
     }   // end else
     else
     {
 #ifndef NDEBUG
         std::cerr << std::endl;
 #endif
-        doAction(e);  // Blocks
-        _endExecute(e);
+        TaskState *ptask = TaskState::setCurrent( _task.get());
+        {
+            const Trace::Scope trace( "action", debugName(), "doAction");
+            doAction(e);  // Blocks
+        }   // end trace scope
+        TaskState::setCurrent( ptask);
+        _endExecute( e, MS::selectedModel());
     }   // end else
 
     return true;
@@ -251,12 +271,18 @@ Event FaceAction::doAfterAction( Event e)
 
 void FaceAction::endNow()
 {
-    std::cerr << _dbgPrfx << " ENDING NOW (TESTING)" << std::endl;
+    if ( _task)
+    {
+#ifndef NDEBUG
+        std::cerr << _dbgPrfx << " Cancelling " << debugName() << std::endl;
+#endif
+        _task->cancel();
+    }   // end if
 }   // end endNow
 
 
 // private slot
-void FaceAction::_endExecute( Event e)   // Always in GUI thread
+void FaceAction::_endExecute( Event e, FM *fm)   // Always in GUI thread
 {
     _isWorking = false;
     if ( _key != 0)
@@ -264,16 +290,65 @@ void FaceAction::_endExecute( Event e)   // Always in GUI thread
         MS::unlockSelect(_key); // Unlock ability to change selected view now that asynchronous action done
         _key = 0;
     }   // end if
-    Event fev = doAfterAction( e);
+
+    // Finish on the model the action worked on (which may no longer be selected) so that the
+    // events it emits are raised against that model. Closed models can't be finished upon.
+    if ( FMM::opened().count(fm) == 0)
+        fm = nullptr;
+
+    FM *pfm = fm ? MS::bindModel( fm) : nullptr;
+    Event fev;
+    {
+        const Trace::Scope trace( "action", debugName(), "doAfterAction");
+        fev = doAfterAction( e);
+    }   // end trace scope
+    if ( fm)
+        MS::bindModel( pfm);
+
+    Trace::addSpan( "action", debugName(), uintptr_t(this), _tstart);  // The whole execution
+    _task = nullptr;
     _mpos = QPoint(-1,-1);
 #ifndef NDEBUG
     std::cerr << _dbgPrfx << " Finished " << debugName() << " emits " << fev << std::endl;
 #endif
-    refresh( fev);
+    refresh( fev);  // For the selected model
+
+    if ( fm)
+        pfm = MS::bindModel( fm);
     emit onEvent( fev);
+    if ( fm)
+        MS::bindModel( pfm);
 }   // end _endExecute
 
 
+// private slot
+void FaceAction::_abortExecute()   // Always in GUI thread
+{
+    _isWorking = false;
+    _task = nullptr;
+    if ( _key != 0)
+    {
+        MS::unlockSelect(_key);
+        _key = 0;
+    }   // end if
+    _mpos = QPoint(-1,-1);
+#ifndef NDEBUG
+    std::cerr << _dbgPrfx << " Dropped " << debugName() << std::endl;
+#endif
+    refresh();
+    emit onEvent( Event::CANCEL);
+}   // end _abortExecute
+
+
+bool FaceAction::_dependsOn( const FaceAction *act) const
+{
+    for ( const QMetaObject *mo = act->metaObject(); mo; mo = mo->superClass())
+        if ( _deps.count(mo) > 0)
+            return true;
+    return false;
+}   // end _dependsOn
+
+
 void FaceAction::saveState( UndoState&) const
 {
     std::cerr << "[ERROR] FaceTools::Action::FaceAction::saveState: [" << debugName() << "] "
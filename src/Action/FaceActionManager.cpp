@@ -23,11 +23,13 @@
 #include <Metric/MetricManager.h>
 #include <FaceModel.h>
 #include <Vis/FaceView.h>
+#include <unordered_set>
 #include <functional>
 #include <algorithm>
 #include <cassert>
 using FaceTools::Action::FaceActionManager;
 using FaceTools::Action::FaceAction;
+using FaceTools::Action::FaceActionWorker;
 using FaceTools::Action::Event;
 using FaceTools::Vis::FV;
 using FMM = FaceTools::FileIO::FaceModelManager;
@@ -66,11 +68,14 @@ void applyFnToModels( const Event &e, FM* fm, const std::function<void( FM*)> &f
 
 
 FaceActionManager::Ptr FaceActionManager::s_singleton;
+const int FaceActionManager::COALESCE_MSECS(50);
 
 
 FaceActionManager::FaceActionManager() : _lvl(0)
 {
     connect( this, &FaceActionManager::_selfRaise, this, &FaceActionManager::_doRaise);
+    _ctimer.setSingleShot(true);
+    connect( &_ctimer, &QTimer::timeout, this, &FaceActionManager::_doFlush);
 }   // end ctor
 
 
@@ -100,6 +105,28 @@ void FaceActionManager::finalise()
     FaceActionManager *fam = get();
     std::vector<FaceAction*>& acts = fam->_actions;
 
+    // Since only earlier scheduled work can block later work (see FaceActionWorker), actions
+    // must be ordered after the actions they depend on so that when both are triggered by
+    // the same event(s) the dependency is scheduled first. Otherwise keep registered order.
+    std::vector<FaceAction*> ordered;
+    std::unordered_set<const FaceAction*> placed, visiting;
+    std::function<void( FaceAction*)> place = [&]( FaceAction *act)
+    {
+        if ( placed.count(act) > 0)
+            return;
+        assert( visiting.count(act) == 0);  // Cyclic dependency
+        visiting.insert(act);
+        for ( FaceAction *dep : acts)
+            if ( dep != act && act->_dependsOn( dep))
+                place( dep);
+        visiting.erase(act);
+        placed.insert(act);
+        ordered.push_back(act);
+    };  // end place
+    for ( FaceAction *act : acts)
+        place( act);
+    acts = ordered;
+
     for ( size_t i = 0; i < acts.size(); ++i)
     {
         FaceAction *act = acts.at(i);
@@ -117,6 +144,9 @@ FaceTools::Vis::FV* FaceActionManager::close( const FM *fm)
 {
     assert(fm);
     FaceActionManager *fam = get();
+    FaceActionWorker::purge( fm);   // Drop work scheduled on the model but not yet started
+    FaceActionWorker::cancel( fm);  // and stop running work early since its results will be discarded
+    fam->_pending.erase( fm);       // Drop actions waiting on coalesced events for the model
     fm->lockForRead();
     const auto& acts = fam->_actions;
     for ( FaceAction* act : acts)
@@ -161,9 +191,28 @@ void FaceActionManager::raise( Event E)
 }   // end raise
 
 
+// static
+void FaceActionManager::schedule( FaceAction *act, const FM *fm, Event E)
+{
+    // Queued in the GUI thread as with raise.
+    FaceActionManager *fam = get();
+    QMetaObject::invokeMethod( fam, [=](){ fam->_doSchedule( act, fm, E);}, Qt::QueuedConnection);
+}   // end schedule
+
+
+void FaceActionManager::_doSchedule( FaceAction *act, const FM *fm, Event E)
+{
+    if ( FMM::opened().count( const_cast<FM*>(fm)) == 0)
+        return;
+    _pending[fm][act] |= E;
+    if ( !_ctimer.isActive())
+        _ctimer.start( COALESCE_MSECS);
+}   // end _doSchedule
+
+
 void FaceActionManager::_doRaise( Event E)
 {
-    FM* fm = MS::selectedModel();
+    FM* fm = MS::selectedModel();   // The bound model if an action is finishing on a non-selected model
     assert( fm || FMM::numOpen() == 0);
     if ( E == Event::CANCEL)
         return;
@@ -173,8 +222,14 @@ void FaceActionManager::_doRaise( Event E)
     // NOTE sact may be null since a FaceAction may not be causing this call!
     FaceAction* sact = qobject_cast<FaceAction*>( sender());
 
+    // Events raised outside of an action cascade have their triggered actions deferred
+    // so that they can be merged with other events raised for the model in the window.
+    const bool coalesce = _lvl == 0 && fm;
+
     if ( fm && E != Event::NONE)
     {
+        emit onRaised( fm, E, sact);
+
         // Purge actions first.
         for ( FaceAction *act : _actions)
             if ( act != sact && act->purges( E) && !act->isWorking())
@@ -217,7 +272,10 @@ void FaceActionManager::_doRaise( Event E)
 
             if ( act->triggers( E)) // Triggers take precedence
             {
-                tacts.push_back(act);
+                if ( coalesce)
+                    _pending[fm][act] |= E;
+                else
+                    tacts.push_back(act);
                 _acted[act] = E;
             }   // end if
             else if ( act->refreshes( E))
@@ -228,6 +286,10 @@ void FaceActionManager::_doRaise( Event E)
         }   // end for
     }   // end if
 
+    // Also start the window if the model has actions pending from before it was last deselected.
+    if ( coalesce && _pending.count(fm) > 0 && !_ctimer.isActive())
+        _ctimer.start( COALESCE_MSECS);
+
     const std::string chevrons( ++_lvl, '>');
 
     // Actions triggered for immediate response by the received action (if we have any)
@@ -273,3 +335,68 @@ void FaceActionManager::_doRaise( Event E)
         emit onUpdateSelected();
     }   // end if
 }   // end _doRaise
+
+
+void FaceActionManager::_doFlush()
+{
+    // Every model with pending actions is flushed and not just the selected one (the selection
+    // may have changed within the window). Each model is bound while its actions execute
+    // so that the actions (and the events they raise) act upon that model.
+    std::vector<FM*> fms;
+    for ( const auto &p : _pending)
+        fms.push_back( const_cast<FM*>( p.first));
+
+    for ( FM *fm : fms)
+    {
+        const auto it = _pending.find(fm);
+        if ( it == _pending.end())  // Model closed by a previously flushed action
+            continue;
+        std::unordered_map<FaceAction*, Event> &pending = it->second;
+
+        std::vector<FaceAction*> tacts;
+        for ( FaceAction *act : _actions)   // Execute in registered order
+        {
+            const auto pit = pending.find(act);
+            // As in _doRaise, running actions and actions already acted upon are skipped,
+            // but they're left pending to be retried in the next window.
+            if ( pit != pending.end() && !act->isWorking() && _acted.count(act) == 0)
+            {
+                tacts.push_back(act);
+                _acted[act] = pit->second;
+                pending.erase(pit);
+            }   // end if
+        }   // end for
+        if ( pending.empty())
+            _pending.erase(it);
+
+        FM *pfm = MS::bindModel( fm);
+        const std::string chevrons( ++_lvl, '>');
+#ifndef NDEBUG
+        if ( !tacts.empty())
+            std::cerr << chevrons << " ===== Executing " << tacts.size() << " coalesced actions ===== " << std::endl;
+#endif
+        for ( FaceAction *act : tacts)
+        {
+#ifndef NDEBUG
+            std::cerr << chevrons << " " << act->debugName() << " due to " << _acted.at(act) << std::endl;
+#endif
+            act->_setDebugPrefix( chevrons);
+            act->execute( _acted.at(act));
+            act->_setDebugPrefix( "!");
+        }   // end for
+        _lvl--;
+        MS::bindModel( pfm);
+        if ( _lvl == 0)
+            _acted.clear();
+    }   // end for
+
+    // Skipped actions are retried once the window elapses again
+    if ( !_pending.empty() && !_ctimer.isActive())
+        _ctimer.start( COALESCE_MSECS);
+
+    if ( _lvl == 0)
+    {
+        MS::updateRender();
+        emit onUpdateSelected();
+    }   // end if
+}   // end _doFlush
@@ -18,19 +18,38 @@
 #include <Action/FaceActionWorker.h>
 #include <Action/FaceAction.h>
 #include <ModelSelect.h>
+#include <Trace.h>
+#include <QThread>
+#include <algorithm>
 using FaceTools::Action::FaceActionWorker;
 using FaceTools::Action::FaceAction;
 using FaceTools::Action::Event;
+using FaceTools::FM;
 using MS = FaceTools::ModelSelect;
 
 
 int FaceActionWorker::_s_userWorkCount(0);
 QMutex FaceActionWorker::_s_mutex;
+std::list<FaceActionWorker*> FaceActionWorker::_s_live;
 
 
-FaceActionWorker::FaceActionWorker( FaceAction* worker, Event e)
-    : QThread(worker), _worker(worker), _event(e), _timer(nullptr), _tcount(0)
+QThreadPool* FaceActionWorker::pool()
 {
+    static QThreadPool *p = []()
+    {
+        QThreadPool *tp = new QThreadPool;
+        tp->setExpiryTimeout(-1);    // Threads persist
+        tp->setMaxThreadCount( std::max( 2, QThread::idealThreadCount()));
+        return tp;
+    }();
+    return p;
+}   // end pool
+
+
+FaceActionWorker::FaceActionWorker( FaceAction* worker, Event e, FM *fm, const TaskState::Ptr &task)
+    : _worker(worker), _event(e), _fm(fm), _task(task), _started(false), _timer(nullptr), _tcount(0)
+{
+    setAutoDelete(false);
     if ( e == Event::USER)
     {
         _s_mutex.lock();
@@ -65,27 +84,110 @@ FaceActionWorker::~FaceActionWorker()
 }   // end dtor
 
 
-void FaceActionWorker::run()    // thread function
+// static
+void FaceActionWorker::schedule( FaceActionWorker *w)
 {
-    _worker->doAction( _event);
-    emit onWorkFinished( _event);
+    QMutexLocker lock( &_s_mutex);
+    _s_live.push_back(w);
+    if ( !w->_isBlocked())
+    {
+        w->_started = true;
+        pool()->start(w);
+    }   // end if
+}   // end schedule
+
+
+// static
+void FaceActionWorker::purge( const FM *fm)
+{
+    std::vector<FaceActionWorker*> dropped;
+    _s_mutex.lock();
+    for ( auto it = _s_live.begin(); it != _s_live.end();)
+    {
+        if ( !(*it)->_started && (*it)->_fm == fm)
+        {
+            dropped.push_back(*it);
+            it = _s_live.erase(it);
+        }   // end if
+        else
+            ++it;
+    }   // end for
+    _s_mutex.unlock();
+
+    for ( FaceActionWorker *w : dropped)
+        emit w->onWorkDropped();
+}   // end purge
+
+
+// static
+void FaceActionWorker::cancel( const FM *fm)
+{
+    QMutexLocker lock( &_s_mutex);
+    for ( FaceActionWorker *w : _s_live)
+        if ( w->_started && w->_fm == fm)
+            w->_task->cancel();
+}   // end cancel
+
+
+// private (with _s_mutex held)
+bool FaceActionWorker::_isBlocked() const
+{
+    // Only workers scheduled earlier can block so the dependency graph is always acyclic.
+    for ( const FaceActionWorker *w : _s_live)
+    {
+        if ( w == this)
+            break;
+        if ( w->_fm == _fm && _worker->_dependsOn( w->_worker))
+            return true;
+    }   // end for
+    return false;
+}   // end _isBlocked
+
+
+// private static (with _s_mutex held)
+void FaceActionWorker::_startUnblocked()
+{
+    for ( FaceActionWorker *w : _s_live)
+    {
+        if ( !w->_started && !w->_isBlocked())
+        {
+            w->_started = true;
+            pool()->start(w);
+        }   // end if
+    }   // end for
+}   // end _startUnblocked
+
+
+void FaceActionWorker::run()    // Pool thread
+{
+    MS::bindModel( _fm);
+    TaskState::setCurrent( _task.get());
+    {
+        const Trace::Scope trace( "action", _worker->debugName(), "doAction");
+        _worker->doAction( _event);
+    }   // end trace scope
+    TaskState::setCurrent( nullptr);
+    MS::bindModel( nullptr);
+
+    _s_mutex.lock();
+    _s_live.remove(this);
+    _startUnblocked();  // Dependents start straight away from this thread
+    _s_mutex.unlock();
+
+    emit onWorkFinished( _event);   // Queued to the GUI thread (may delete this)
 }   // end run
 
 
 void FaceActionWorker::_doOnTimerInterval()
 {
-    static const int MAX_TIME_OUT = 120;  // seconds
-    _tcount++;
-    if ( _tcount == MAX_TIME_OUT)
-    {
-        requestInterruption();
-        _status += " timed out!";
-        _deleteTimer();
-        _worker->endNow();
-    }   // end if
-    else if ( _tcount < MAX_TIME_OUT)
+    static const int MAX_DOTS = 120;
+    if ( _tcount++ < MAX_DOTS)
         _status += ".";
-    MS::showStatus( _status);
+    const float p = _task->progress();
+    if ( p > 0.0f)
+        MS::showStatus( QString("%1 %2%").arg(_status).arg( int(100 * p)));
+    else
+        MS::showStatus( _status);
 }   // end _doOnTimerInterval
 
 
@@ -18,6 +18,9 @@
 #include <Action/FaceModelState.h>
 #include <ModelSelect.h>
 #include <FaceModel.h>
+#include <FileIO/BinaryMesh.h>
+#include <QFile>
+#include <fstream>
 using FaceTools::Action::FaceModelState;
 using FaceTools::Action::Event;
 using FaceTools::FM;
@@ -38,9 +41,123 @@ void FaceModelState::_saveMesh()
 }   // end _saveMesh
 
 
+FaceModelState::~FaceModelState()
+{
+    if ( isSpilled())
+        QFile::remove( _spill);
+}   // end dtor
+
+
+size_t FaceModelState::meshBytes( const r3d::Mesh &mesh)
+{
+    // Per vertex: positions, vertex-face and vertex-vertex connectivity.
+    // Per face: vertex indices, edges and texture coordinates.
+    size_t nbytes = mesh.numVtxs() * 160 + mesh.numFaces() * 96;
+    for ( int mid : mesh.materialIds())
+    {
+        const cv::Mat &tx = mesh.texture(mid);
+        nbytes += tx.total() * tx.elemSize();
+    }   // end for
+    return nbytes;
+}   // end meshBytes
+
+
+size_t FaceModelState::memoryUsage() const
+{
+    if ( !_mesh || _mesh.use_count() > 1)   // Spilled, not saved, or shared
+        return 0;
+    // Add the search tree (position and index per vertex) and manifolds (face index per face).
+    return meshBytes( *_mesh) + _mesh->numVtxs() * (sizeof(Vec3f) + 2*sizeof(size_t))
+                              + _mesh->numFaces() * 4*sizeof(int);
+}   // end memoryUsage
+
+
+bool FaceModelState::writeSpill( const r3d::Mesh &mesh, const QString &fpath)
+{
+    // Binary meshes hold transformed vertices so the transform is written first to undo this on reading.
+    std::ofstream ofs( fpath.toLocal8Bit().toStdString(), std::ios::binary);
+    if ( !ofs.is_open())
+        return false;
+    const Mat4f T = mesh.transformMatrix();
+    ofs.write( reinterpret_cast<const char*>( T.data()), sizeof(float)*16);
+    bool ok = FileIO::writeBinaryMesh( mesh, ofs);
+    ofs.close();    // Flushes so a full disk shows up in the stream state
+    ok = ok && !ofs.fail();
+    if ( !ok)
+        QFile::remove( fpath);  // Never leave a partial spill file to be read back
+    return ok;
+}   // end writeSpill
+
+
+r3d::Mesh::Ptr FaceModelState::readSpill( const QString &fpath)
+{
+    std::ifstream ifs( fpath.toLocal8Bit().toStdString(), std::ios::binary);
+    if ( !ifs.is_open())
+        return nullptr;
+    Mat4f T;
+    if ( !ifs.read( reinterpret_cast<char*>( T.data()), sizeof(float)*16))
+        return nullptr;
+    r3d::Mesh::Ptr mesh = FileIO::readBinaryMesh( ifs);
+    if ( mesh)
+    {
+        mesh->addTransformMatrix( T.inverse());
+        mesh->fixTransformMatrix();
+        mesh->addTransformMatrix( T);
+    }   // end if
+    return mesh;
+}   // end readSpill
+
+
+r3d::Mesh::Ptr FaceModelState::spillMesh() const
+{
+    // Nothing is freed by spilling a shared mesh, and repacking a mesh without sequential
+    // IDs (as writing requires) would change the IDs the rest of the model refers to.
+    if ( !_mesh || _mesh.use_count() > 1 || !_mesh->hasSequentialIds())
+        return nullptr;
+    return _mesh;
+}   // end spillMesh
+
+
+bool FaceModelState::setSpilled( const r3d::Mesh::Ptr &mesh, const QString &fpath)
+{
+    if ( _mesh != mesh || _mesh.use_count() > 2)  // Held by this state and the caller only
+        return false;
+    _spill = fpath;
+    _mesh = nullptr;
+    _kdtree = nullptr;
+    _manifolds = nullptr;
+    return true;
+}   // end setSpilled
+
+
+bool FaceModelState::unspill()
+{
+    if ( !isSpilled())
+        return true;
+    r3d::Mesh::Ptr mesh = readSpill( _spill);
+    if ( !mesh)
+    {
+        std::cerr << "[WARN] FaceTools::Action::FaceModelState::unspill: Unable to read " << _spill.toStdString() << std::endl;
+        return false;
+    }   // end if
+
+    // Rebuild the search tree and manifolds as FaceModel::update does.
+    r3d::Manifolds::Ptr manf = r3d::Manifolds::create( *mesh);
+    const int nm = static_cast<int>( manf->count());
+    for ( int i = 0; i < nm; ++i)
+        manf->at(i).boundaries();  // Causes boundary edges to be calculated
+    _mesh = mesh;
+    _kdtree = r3d::KDTree::create( *mesh);
+    _manifolds = manf;
+    QFile::remove( _spill);
+    _spill = "";
+    return true;
+}   // end unspill
+
+
 void FaceModelState::_restoreMesh() const
 {
-    assert(_mesh);
+    assert(_mesh);  // Must have been unspilled
     _fm->_mesh = _mesh;
     _fm->_kdtree = _kdtree;
     _fm->_manifolds = _manifolds;
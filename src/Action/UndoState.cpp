@@ -18,6 +18,8 @@
 #include <Action/UndoState.h>
 #include <Action/UndoStates.h>
 #include <Action/FaceAction.h>
+#include <QFile>
+#include <atomic>
 #include <cassert>
 using FaceTools::Action::UndoState;
 using FaceTools::Action::FaceAction;
@@ -45,8 +47,12 @@ UndoState::Ptr UndoState::create( const FaceAction* a, Event egrp, bool autoRest
 
 UndoState::UndoState( const FaceAction* a, Event egrp, bool ar)
     : _action( const_cast<FaceAction*>(a)), _egrp(egrp), _autoRestore(ar),
-      _name(a->displayName()), _sfm( MS::selectedModel()) // Could be null
+      _name(a->displayName()), _sfm( MS::selectedModel()), // Could be null
+      _spilling(false)
 {
+    static std::atomic<size_t> nextSeq(0);
+    _seq = nextSeq++;
+
     // If auto-restoring, backup the needed data elements otherwise the setUserData function will be used.
     if ( isAutoRestore())
     {
@@ -71,22 +77,135 @@ UndoState::UndoState( const FaceAction* a, Event egrp, bool ar)
 }   // end ctor
 
 
+UndoState::~UndoState()
+{
+    for ( const QString &fpath : _uspill)
+        QFile::remove( fpath);
+}   // end dtor
+
+
 void UndoState::setUserData( const QString& s, const QVariant& v)
 {
     _udata[s] = v;
+    if ( _uspill.contains(s))
+        QFile::remove( _uspill.take(s));
 }   // end setUserData
 
 
 QVariant UndoState::userData( const QString& s) const
 {
+    assert( !_uspill.contains(s));
     assert( _udata.contains(s));
     return _udata[s];
 }   // end userData
 
 
+size_t UndoState::memoryUsage() const
+{
+    if ( _spilling) // Assume the outstanding spill jobs will free everything
+        return 0;
+    size_t nbytes = 0;
+    for ( const FaceModelState::Ptr &fstate : _fstates)
+        nbytes += fstate->memoryUsage();
+    // Meshes set as user data are (by convention) deep copies so are held only by this state.
+    for ( const QVariant &v : _udata)
+    {
+        if ( v.canConvert<r3d::Mesh::Ptr>())
+        {
+            const r3d::Mesh::Ptr mesh = v.value<r3d::Mesh::Ptr>();
+            if ( mesh)
+                nbytes += FaceModelState::meshBytes( *mesh);
+        }   // end if
+    }   // end for
+    return nbytes;
+}   // end memoryUsage
+
+
+std::vector<UndoState::SpillJob> UndoState::spillJobs( const QString &fpfx)
+{
+    std::vector<SpillJob> jobs;
+    if ( _spilling)
+        return jobs;
+
+    int i = 0;
+    for ( size_t j = 0; j < _fstates.size(); ++j)
+    {
+        r3d::Mesh::Ptr mesh = _fstates[j]->spillMesh();
+        if ( mesh)
+            jobs.push_back( {mesh, QString("%1_%2.bin").arg(fpfx).arg(i++), int(j), "", false});
+    }   // end for
+
+    for ( auto it = _udata.begin(); it != _udata.end(); ++it)
+    {
+        if ( !it.value().canConvert<r3d::Mesh::Ptr>())
+            continue;
+        r3d::Mesh::Ptr mesh = it.value().value<r3d::Mesh::Ptr>();
+        if ( mesh && mesh->hasSequentialIds())
+            jobs.push_back( {mesh, QString("%1_%2.bin").arg(fpfx).arg(i++), -1, it.key(), false});
+    }   // end for
+
+    _spilling = !jobs.empty();
+    return jobs;
+}   // end spillJobs
+
+
+void UndoState::setSpilled( const std::vector<SpillJob> &jobs)
+{
+    _spilling = false;
+    for ( const SpillJob &job : jobs)
+    {
+        bool spilled = false;
+        if ( job.written && job.fidx >= 0)
+            spilled = _fstates[size_t(job.fidx)]->setSpilled( job.mesh, job.fpath);
+        else if ( job.written && _udata.contains( job.key) && !_uspill.contains( job.key)
+               && _udata[job.key].value<r3d::Mesh::Ptr>() == job.mesh)    // Not reset in the meantime
+        {
+            _uspill[job.key] = job.fpath;
+            _udata[job.key] = QVariant();
+            spilled = true;
+        }   // end else if
+        if ( !spilled)
+            QFile::remove( job.fpath);
+    }   // end for
+}   // end setSpilled
+
+
+// private
+bool UndoState::_unspill() const
+{
+    // Read back all spilled meshes first so that nothing is restored if any can't be read.
+    for ( const FaceModelState::Ptr &fstate : _fstates)
+        if ( !fstate->unspill())
+            return false;
+
+    while ( !_uspill.isEmpty())
+    {
+        const QString key = _uspill.firstKey();
+        const QString fpath = _uspill.first();
+        r3d::Mesh::Ptr mesh = FaceModelState::readSpill( fpath);
+        if ( !mesh)
+        {
+            std::cerr << "[WARN] FaceTools::Action::UndoState::_unspill: Unable to read " << fpath.toStdString() << std::endl;
+            return false;
+        }   // end if
+        _udata[key] = QVariant::fromValue( mesh);
+        _uspill.remove( key);
+        QFile::remove( fpath);
+    }   // end while
+
+    return true;
+}   // end _unspill
+
+
 Event UndoState::restore() const
 {
     assert(_action != nullptr);
+    if ( !_unspill())
+    {
+        std::cerr << "[WARN] FaceTools::Action::UndoState::restore: Unable to restore '" << _name.toStdString() << "'!" << std::endl;
+        return Event::NONE;
+    }   // end if
+
     if ( !isAutoRestore())
         _action->restoreState(*this);    // Call the custom restore function
     else
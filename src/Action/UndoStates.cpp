@@ -17,11 +17,18 @@
 
 #include <Action/UndoStates.h>
 #include <Action/FaceAction.h>
+#include <QThreadPool>
+#include <QRunnable>
 #include <QThread>
+#include <QFile>
+#include <algorithm>
+#include <functional>
+#include <unordered_set>
 #include <cassert>
 using FaceTools::Action::UndoStates;
 using FaceTools::Action::UndoState;
 using FaceTools::Action::FaceAction;
+using FaceTools::Action::FaceModelState;
 using FaceTools::Action::Event;
 using FaceTools::FM;
 using MS = FaceTools::ModelSelect;
@@ -30,14 +37,202 @@ using MS = FaceTools::ModelSelect;
 UndoStates::Ptr UndoStates::_singleton;
 
 
+namespace {
+
+class SpillTask : public QRunnable
+{
+public:
+    explicit SpillTask( const std::function<void()> &fn) : _fn(fn) { setAutoDelete(true);}
+    void run() override { _fn();}
+private:
+    std::function<void()> _fn;
+};  // end class
+
+
+// Spill files are written one at a time on their own thread so that
+// spilling never competes with actions for the worker pool's threads.
+QThreadPool* spillPool()
+{
+    static QThreadPool *p = []()
+    {
+        QThreadPool *tp = new QThreadPool;
+        tp->setMaxThreadCount(1);
+        return tp;
+    }();
+    return p;
+}   // end spillPool
+
+}   // end namespace
+
+
 UndoStates::Ptr UndoStates::get()
 {
     if ( !_singleton)
-        _singleton = Ptr( new UndoStates);
+        _singleton = Ptr( new UndoStates, []( UndoStates *x){ delete x;});
     return _singleton;
 }   // end get
 
 
+UndoStates::UndoStates() : _budget( size_t(512) << 20), _sdir(nullptr) {}
+
+
+UndoStates::~UndoStates()
+{
+    _stacks.clear();    // Remove spill files before their directory
+    delete _sdir;
+}   // end dtor
+
+
+void UndoStates::setBudget( size_t b)
+{
+    UndoStates *us = get().get();
+    us->_mutex.lockForWrite();
+    us->_budget = b;
+    SpillJobs sjobs = us->_enforceBudget();
+    us->_mutex.unlock();
+    us->_spill( std::move( sjobs));
+    emit us->onUpdated();
+}   // end setBudget
+
+
+size_t UndoStates::budget()
+{
+    UndoStates *us = get().get();
+    QReadLocker lock( &us->_mutex);
+    return us->_budget;
+}   // end budget
+
+
+size_t UndoStates::usage()
+{
+    UndoStates *us = get().get();
+    QReadLocker lock( &us->_mutex);
+    return us->_usage();
+}   // end usage
+
+
+// private (with _mutex held)
+size_t UndoStates::_usage() const
+{
+    std::unordered_set<const UndoState*> counted;   // Redos and oldRedos share states
+    size_t nbytes = 0;
+    for ( const auto &p : _stacks)
+        for ( const std::deque<UndoState::Ptr> *dq : {&p.second.undos, &p.second.redos, &p.second.oldRedos})
+            for ( const UndoState::Ptr &us : *dq)
+                if ( counted.insert( us.get()).second)
+                    nbytes += us->memoryUsage();
+    return nbytes;
+}   // end _usage
+
+
+// private (with _mutex held for writing)
+UndoStates::SpillJobs UndoStates::_enforceBudget()
+{
+    SpillJobs sjobs;
+    if ( _budget == 0)
+        return sjobs;
+
+    size_t nbytes = _usage();
+    if ( nbytes <= _budget)
+        return sjobs;
+
+    // Spill the oldest states first (across all models).
+    std::vector<UndoState::Ptr> ustates;
+    std::unordered_set<const UndoState*> seen;
+    for ( const auto &p : _stacks)
+        for ( const std::deque<UndoState::Ptr> *dq : {&p.second.undos, &p.second.redos, &p.second.oldRedos})
+            for ( const UndoState::Ptr &us : *dq)
+                if ( seen.insert( us.get()).second)
+                    ustates.push_back( us);
+    std::sort( ustates.begin(), ustates.end(), []( const UndoState::Ptr &a, const UndoState::Ptr &b){ return a->_seq < b->_seq;});
+
+    if ( !_sdir)
+    {
+        _sdir = new QTemporaryDir;
+        if ( !_sdir->isValid())
+            std::cerr << "[WARN] FaceTools::Action::UndoStates::_enforceBudget: Unable to create spill directory!" << std::endl;
+    }   // end if
+
+    // Only collect the meshes to spill here since writing them is slow. Their memory is
+    // counted as freed already (the states report zero usage until the jobs complete).
+    if ( _sdir->isValid())
+    {
+        for ( const UndoState::Ptr &us : ustates)
+        {
+            if ( nbytes <= _budget)
+                break;
+            const size_t ubytes = us->memoryUsage();
+            if ( ubytes == 0)
+                continue;
+            std::vector<UndoState::SpillJob> jobs = us->spillJobs( _sdir->filePath( QString("undo%1").arg(us->_seq)));
+            if ( !jobs.empty())
+            {
+                const size_t rbytes = us->memoryUsage();
+                nbytes -= std::min( nbytes, ubytes - rbytes);
+                sjobs.push_back( std::make_pair( std::weak_ptr<UndoState>(us), std::move(jobs)));
+            }   // end if
+        }   // end for
+    }   // end if
+
+    // Failing that, discard the oldest undos (never the most recent for a model).
+    while ( nbytes > _budget)
+    {
+        Stacks *oldest = nullptr;
+        for ( auto &p : _stacks)
+            if ( p.second.undos.size() > 1 && (!oldest || p.second.undos.back()->_seq < oldest->undos.back()->_seq))
+                oldest = &p.second;
+        if ( !oldest)
+            break;
+        const size_t ubytes = oldest->undos.back()->memoryUsage();
+        oldest->undos.pop_back();
+        nbytes -= std::min( nbytes, ubytes);
+    }   // end while
+
+    return sjobs;
+}   // end _enforceBudget
+
+
+// private (without _mutex held)
+void UndoStates::_spill( SpillJobs &&sjobs)
+{
+    if ( sjobs.empty())
+        return;
+
+    // The singleton is held by the task so it outlives any outstanding writes.
+    Ptr self = get();
+    std::shared_ptr<SpillJobs> pjobs = std::make_shared<SpillJobs>( std::move( sjobs));
+    spillPool()->start( new SpillTask( [self, pjobs]()
+    {
+        for ( auto &p : *pjobs)
+        {
+            for ( UndoState::SpillJob &job : p.second)
+            {
+                job.written = FaceModelState::writeSpill( *job.mesh, job.fpath);
+                if ( !job.written)
+                    std::cerr << "[WARN] FaceTools::Action::UndoStates::_spill: Unable to write " << job.fpath.toStdString() << std::endl;
+            }   // end for
+        }   // end for
+
+        // Swap in the spill files for the meshes of the states that still exist. This happens back
+        // in the GUI thread so it can't interleave with states being restored (outside the lock).
+        QMetaObject::invokeMethod( self.get(), [self, pjobs]()
+        {
+            self->_mutex.lockForWrite();
+            for ( auto &p : *pjobs)
+            {
+                UndoState::Ptr us = p.first.lock();
+                if ( us)
+                    us->setSpilled( p.second);
+                else
+                    for ( const UndoState::SpillJob &job : p.second)
+                        QFile::remove( job.fpath);
+            }   // end for
+            self->_mutex.unlock();
+        }, Qt::QueuedConnection);
+    }));
+}   // end _spill
+
+
 void UndoStates::clear( const FM* fm) { get()->_clear(fm);}
 void UndoStates::_clear( const FM* fm)
 {
@@ -64,7 +259,9 @@ void UndoStates::_storeUndo( const FaceAction* a, Event e, bool autoRestore)
     stacks.undos.push_front( us);   // Push to undo stack
     stacks.oldRedos = stacks.redos; // In case of scrapping - can roll back
     stacks.redos.clear(); // Clear the redo stack
+    SpillJobs sjobs = _enforceBudget();
     _mutex.unlock();
+    _spill( std::move( sjobs));
     emit onUpdated();
 }   // end _storeUndo
 
@@ -146,9 +343,19 @@ Event UndoStates::_undo( const FM *fm)
         ustate->action()->saveState( *rstate);
     stacks.redos.push_front( rstate);
     stacks.oldRedos.clear();
+    SpillJobs sjobs = _enforceBudget();
     _mutex.unlock();
+    _spill( std::move( sjobs));
 
     Event e = ustate->restore();
+    if ( e == Event::NONE)  // Unrestorable so discard it along with the redo state just stored
+    {
+        _mutex.lockForWrite();
+        const auto it = _stacks.find(fm);
+        if ( it != _stacks.end() && !it->second.redos.empty() && it->second.redos.front() == rstate)
+            it->second.redos.pop_front();
+        _mutex.unlock();
+    }   // end if
     emit get()->onUpdated();
     return e;
 }   // end _undo
@@ -168,9 +375,19 @@ Event UndoStates::_redo( const FM *fm)
     if ( !rstate->isAutoRestore())
         rstate->action()->saveState( *ustate);
     stacks.undos.push_front( ustate);
+    SpillJobs sjobs = _enforceBudget();
     _mutex.unlock();
+    _spill( std::move( sjobs));
 
     Event e = rstate->restore();
+    if ( e == Event::NONE)  // Unrestorable so discard it along with the undo state just stored
+    {
+        _mutex.lockForWrite();
+        const auto it = _stacks.find(fm);
+        if ( it != _stacks.end() && !it->second.undos.empty() && it->second.undos.front() == ustate)
+            it->second.undos.pop_front();
+        _mutex.unlock();
+    }   // end if
     emit get()->onUpdated();
     return e;
 }   // end _redo
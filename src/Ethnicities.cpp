@@ -30,37 +30,34 @@ int Ethnicities::_lt(-100);   // decrements
 std::unordered_map<int, IntSet> Ethnicities::_groups;
 std::unordered_map<int, IntSet> Ethnicities::_rgroups;
 std::list<int> Ethnicities::_codes;
+std::unordered_map<int, int> Ethnicities::_index;
+std::vector<int> Ethnicities::_icodes;
+std::vector<std::vector<int8_t> > Ethnicities::_closure[2];
 
 
 namespace {
 static const QString EMPTY_STRING = "";
 static const IntSet EMPTY_INT_SET;
 
-QString scode( int code)
-{
-    code = abs(code);
-    const QString s = QString("%1").arg(code, 4, 10, QLatin1Char('0')); // e.g. 904 --> "0904"
-    assert( s.length() == 4);
-    return s;
-}   // end scode
-
-int broadCode( int code) { return scode(code).left(1).toInt() * 1000;}     // 0-9
-int narrowCode( int code) { return scode(code).left(2).toInt() * 100;}
+// Codes are four digits (e.g. 904 is "0904") so the broad group is the first
+// digit and the narrow group the first two digits.
+int broadCode( int code) { return (abs(code) / 1000) * 1000;}     // 0-9
+int narrowCode( int code) { return (abs(code) / 100) * 100;}
 
 }   // end namespace
 
 
 bool Ethnicities::isBroad( int code)
 {
-    const QString ncode = scode(code);
-    return ncode.left(1).toInt() > 0 && ncode.right(3) == "000";
+    code = abs(code);
+    return code / 1000 > 0 && code % 1000 == 0;
 }   // end isBroad
 
 
 bool Ethnicities::isNarrow( int code)
 {
-    const QString ncode = scode(code);
-    return ncode.left(2).toInt() % 10 != 0 && ncode.right(2).toInt() == 0;
+    code = abs(code);
+    return (code / 100) % 10 != 0 && code % 100 == 0;
 }   // end isNarrow
 
 
@@ -101,10 +98,49 @@ const QString& Ethnicities::name( int code)
 
 bool Ethnicities::belongs( int pc, int cc, bool allBelong)
 {
-    return _belongs( pc, cc, allBelong) >= 0;
+    return parentDegree( pc, cc, allBelong) >= 0;
 }   // end belongs
 
 
+int Ethnicities::index( int code)
+{
+    const auto it = _index.find(code);
+    return it != _index.end() ? it->second : -1;
+}   // end index
+
+
+int Ethnicities::parentDegreeAt( int pidx, int cidx, bool allBelong)
+{
+    const int n = int(_icodes.size());
+    if ( pidx < 0 || pidx >= n || cidx < 0 || cidx >= n)
+        return -1;
+    return _closure[allBelong ? 1 : 0][size_t(pidx)][size_t(cidx)];
+}   // end parentDegreeAt
+
+
+void Ethnicities::_addToClosure( int code)
+{
+    if ( code == 0 || _index.count(code) > 0)
+        return;
+
+    const size_t idx = _icodes.size();
+    _index[code] = int(idx);
+    _icodes.push_back(code);
+
+    // Relations between existing codes are unaffected by the new one (it is a child of nothing
+    // new and only parents existing codes) so only its row and column need calculating.
+    for ( int ab = 0; ab < 2; ++ab)
+    {
+        std::vector<std::vector<int8_t> >& cls = _closure[ab];
+        for ( size_t i = 0; i < idx; ++i)
+            cls[i].push_back( int8_t( _belongs( _icodes[i], code, ab == 1)));
+        cls.emplace_back( idx+1);
+        for ( size_t i = 0; i <= idx; ++i)
+            cls[idx][i] = int8_t( _belongs( code, _icodes[i], ab == 1));
+    }   // end for
+}   // end _addToClosure
+
+
 int Ethnicities::load( const QString& fname)
 {
     QTemporaryFile* tmpfile = writeToTempFile(fname);
@@ -116,6 +152,10 @@ int Ethnicities::load( const QString& fname)
     _lnames.clear();
     _groups.clear();
     _rgroups.clear();
+    _index.clear();
+    _icodes.clear();
+    _closure[0].clear();
+    _closure[1].clear();
     _lt = -100;
 
     const QString fpath = tmpfile->fileName();
@@ -205,6 +245,16 @@ int Ethnicities::load( const QString& fname)
     }   // end for
 
     _codes.sort();
+
+    // Compile the containment closure over all codes including any implied broad
+    // and narrow groups that weren't explicitly named in the file.
+    for ( int c : _codes)
+        _addToClosure(c);
+    for ( const auto& p : _groups)
+        _addToClosure(p.first);
+    for ( const auto& p : _rgroups)
+        _addToClosure(p.first);
+
     return lrecs;
 }   // end load
 
@@ -241,6 +291,7 @@ int Ethnicities::makeMixedCode( const IntSet &eset)
         _groups[emix].insert(e);
         _rgroups[e].insert(emix);
     }   // end for
+    _addToClosure(emix);
 
     return emix;
 }   // end makeMixedCode
@@ -292,7 +343,9 @@ int Ethnicities::codeMix( const IntSet& cmix)
 
 int Ethnicities::parentDegree( int pc, int cc, bool allBelong)
 {
-    return _belongs( pc, cc, allBelong);
+    if ( pc == cc)
+        return 0;
+    return parentDegreeAt( index(pc), index(cc), allBelong);
 }   // end parentDegree
 
 
@@ -307,7 +360,7 @@ int Ethnicities::_findSharedParent( int& pc, int cc, bool allBelong)
     // with the hope that eventually a parent of cc will be found
     while ( pc > 0)
     {
-        nlvls = _belongs( pc, cc, allBelong);
+        nlvls = parentDegree( pc, cc, allBelong);
         if ( nlvls >= 0)
             break;
 
@@ -17,6 +17,7 @@
 
 #include <FaceModel.h>
 #include <FaceTools.h>
+#include <Trace.h>
 #include <Vis/FaceView.h>
 #include <algorithm>
 #include <cassert>
@@ -62,6 +63,10 @@ FaceModel::FaceModel()
 void FaceModel::update( r3d::Mesh::Ptr mesh, bool updateConnectivity, bool settleLandmarks, int maxManifolds)
 {
     assert( mesh);
+    const Trace::Scope trace( "model", "FaceModel::update");
+
+    r3d::KDTree::Ptr kdtree;
+    bool sameBounds = false;    // True if the existing bounds remain valid for the new mesh
 
     if ( updateConnectivity)
     {
@@ -82,12 +87,21 @@ void FaceModel::update( r3d::Mesh::Ptr mesh, bool updateConnectivity, bool settl
         if ( maxManifolds <= 0)
             maxManifolds = MAX_MANIFOLDS;
 
-        r3d::Manifolds::Ptr manf = r3d::Manifolds::create( *mesh);
+        // The search tree depends only on the vertices so build it (on the shared pool) while parsing the manifolds.
+        r3d::Manifolds::Ptr manf;
+        const auto makeTreeAndManifolds = [&]( size_t i)
+        {
+            if ( i == 0)
+                kdtree = r3d::KDTree::create( *mesh);
+            else
+                manf = r3d::Manifolds::create( *mesh);
+        };  // end makeTreeAndManifolds
+        FaceTools::parallelFor( 2, makeTreeAndManifolds, 1);
         if ( int(manf->count()) > maxManifolds)
         {
             //std::cerr << imsg << "Reducing from " << manf->count() << " to " << maxManifolds << " manifolds..." << std::endl;
             mesh = manf->reduceManifolds( maxManifolds);
-            manf = r3d::Manifolds::create( *mesh);
+            FaceTools::parallelFor( 2, makeTreeAndManifolds, 1);  // Tree for the unreduced mesh is discarded
         }   // end if
 
         const int nm = static_cast<int>( manf->count());
@@ -99,15 +113,48 @@ void FaceModel::update( r3d::Mesh::Ptr mesh, bool updateConnectivity, bool settl
         }   // end for
         _manifolds = manf;
     }   // end updateConnectivity
+    else if ( _mesh && _kdtree && _sameVertices( *_mesh, *mesh))
+    {
+        // Connectivity and (transformed) vertex positions are unchanged (e.g. on fixing the transform
+        // matrix or on changing face winding) so the search tree remains valid. The bounds also
+        // remain valid if the transform matrix is the same.
+        sameBounds = !_bnds.empty() && _mesh->transformMatrix().isApprox( mesh->transformMatrix());
+    }   // end else if
+    else
+        kdtree = r3d::KDTree::create( *mesh);
 
     _mesh = mesh;
-    _kdtree = r3d::KDTree::create( *_mesh);
-    if ( settleLandmarks)
+    if ( kdtree)
+        _kdtree = kdtree;
+
+    if ( settleLandmarks && !sameBounds)
+    {
+        // Bounds depend only on the mesh and manifolds so remake them (on the shared pool)
+        // while reseating the landmarks. Neither touches the saved flags which are set below.
+        FaceTools::parallelFor( 2, [this]( size_t i){ if ( i == 0) _moveToSurface(); else _makeBounds();}, 1);
+    }   // end if
+    else if ( settleLandmarks)
         _moveToSurface();
-    remakeBounds();
+    else if ( !sameBounds)
+        _makeBounds();
+
+    setMetaSaved( false);
+    setModelSaved( false);
 }   // end update
 
 
+bool FaceModel::_sameVertices( const r3d::Mesh &m0, const r3d::Mesh &m1)
+{
+    if ( m0.numVtxs() != m1.numVtxs() || !m0.hasSequentialIds() || !m1.hasSequentialIds())
+        return false;
+    const int N = int(m0.numVtxs());
+    for ( int i = 0; i < N; ++i)
+        if ( m0.vtx(i) != m1.vtx(i))
+            return false;
+    return true;
+}   // end _sameVertices
+
+
 void FaceModel::fixTransformMatrix()
 {
     r3d::Mesh::Ptr nmesh = _mesh->deepCopy();
@@ -123,6 +170,14 @@ void FaceModel::fixTransformMatrix()
 
 
 void FaceModel::remakeBounds()
+{
+    _makeBounds();
+    setMetaSaved( false);
+    setModelSaved( false);
+}   // end remakeBounds
+
+
+void FaceModel::_makeBounds()
 {
     assert(_manifolds);
     const Mat4f T = transformMatrix();
@@ -140,10 +195,7 @@ void FaceModel::remakeBounds()
     _bnds[0] = _bnds[1]->deepCopy();
     for ( size_t i = 2; i < nm+1; ++i)
         _bnds[0]->encompass(*_bnds[i]);
-
-    setMetaSaved( false);
-    setModelSaved( false);
-}   // end remakeBounds
+}   // end _makeBounds
 
 
 Mat4f FaceModel::transformMatrix() const { return _mesh->transformMatrix();}
@@ -16,6 +16,7 @@
  ************************************************************************/
 
 #include <FaceModelCurvature.h>
+#include <SurfaceDataBudget.h>
 #include <r3dvis/SurfaceMapper.h>
 #include <r3dvis/VtkTools.h>    // makeNormals
 #include <r3d/CurvatureMetrics.h>
@@ -24,16 +25,45 @@ using FaceTools::FaceModelCurvature;
 
 FaceModelCurvature::Ptr FaceModelCurvature::create( const r3d::Mesh &mesh)
 {
-    return Ptr( new FaceModelCurvature(mesh), []( FaceModelCurvature* d){ delete d;});
+    Ptr fmc( new FaceModelCurvature(mesh), []( FaceModelCurvature* d){ delete d;});
+    fmc->updateArrays();
+    return fmc;
 }   // end create
 
 
+FaceModelCurvature::Ptr FaceModelCurvature::create( const r3d::Mesh &mesh, const std::vector<vtkSmartPointer<vtkFloatArray> > &arrs)
+{
+    const vtkIdType nv = vtkIdType( mesh.numVtxs());
+    if ( arrs.size() != 4)
+        return nullptr;
+    for ( size_t i = 0; i < 4; ++i)
+        if ( !arrs[i] || arrs[i]->GetNumberOfTuples() != nv || arrs[i]->GetNumberOfComponents() != (i < 3 ? 1 : 3))
+            return nullptr;
+
+    Ptr fmc( new FaceModelCurvature(mesh), []( FaceModelCurvature* d){ delete d;});
+    fmc->_mcrv = arrs[0];
+    fmc->_acrv = arrs[1];
+    fmc->_dcrv = arrs[2];
+    fmc->_nrms = arrs[3];
+    fmc->_mcrv->SetName("FaceModelCurvature_Mean");
+    fmc->_acrv->SetName("FaceModelCurvature_Abs");
+    fmc->_dcrv->SetName("FaceModelCurvature_D2");
+    fmc->_nrms->SetName("Normals");
+    return fmc;
+}   // end create
+
+
+// private
+FaceModelCurvature::FaceModelCurvature( const r3d::Mesh &mesh) : _mesh(mesh) {}
+
+
 // private
-FaceModelCurvature::FaceModelCurvature( const r3d::Mesh &mesh)
-    : _cmap( r3d::Curvature::create( mesh))
+r3d::Curvature &FaceModelCurvature::_map() const
 {
-    updateArrays();
-}   // end ctor
+    std::call_once( _cmapOnce, [this](){ _cmap = r3d::Curvature::create( _mesh);});
+    return *_cmap;
+}   // end _map
+
 
 // private
 FaceModelCurvature::~FaceModelCurvature(){}
@@ -41,10 +71,11 @@ FaceModelCurvature::~FaceModelCurvature(){}
 
 void FaceModelCurvature::updateArrays()
 {
-    const r3d::Mesh &mesh = _cmap->mesh();
-    _nrms = r3dvis::makeNormals( *_cmap);
+    const r3d::Curvature &cmap = _map();
+    const r3d::Mesh &mesh = cmap.mesh();
+    _nrms = r3dvis::makeNormals( cmap);
     _nrms->SetName("Normals");
-    const r3d::CurvatureMetrics cm( *_cmap);
+    const r3d::CurvatureMetrics cm( cmap);
     const auto meanCurvFn = [&]( int i, size_t)
             { return 90.0f * (cm.vertexKP1FirstOrder(i) + cm.vertexKP2FirstOrder(i))/2;};
     const auto absCurvFn = [&]( int i, size_t)
@@ -55,3 +86,17 @@ void FaceModelCurvature::updateArrays()
     _acrv = VSM(  absCurvFn, 1).makeArray( mesh, "FaceModelCurvature_Abs");
     _dcrv = VSM(   d2CurvFn, 1).makeArray( mesh, "FaceModelCurvature_D2");
 }   // end updateArrays
+
+
+size_t FaceModelCurvature::memoryUsage() const
+{
+    using SDB = SurfaceDataBudget;
+    // Curvature map (if calculated) holds principal curvature vectors and magnitudes and
+    // a normal per vertex and the normal and area per face.
+    size_t nbytes = 0;
+    if ( _cmap)
+        nbytes += _mesh.numVtxs() * (3 * sizeof(Vec3f) + 2 * sizeof(float))
+                + _mesh.numFaces() * (sizeof(Vec3f) + sizeof(float));
+    nbytes += SDB::bytes( _nrms) + SDB::bytes( _mcrv) + SDB::bytes( _acrv) + SDB::bytes( _dcrv);
+    return nbytes;
+}   // end memoryUsage
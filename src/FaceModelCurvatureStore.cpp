@@ -16,39 +16,77 @@
  ************************************************************************/
 
 #include <FaceModelCurvatureStore.h>
+#include <SurfaceDataArchive.h>
+#include <Trace.h>
 #include <cassert>
 using FaceTools::FaceModelCurvatureStore;
 using FMC = FaceTools::FaceModelCurvature;
+using SDB = FaceTools::SurfaceDataBudget;
+using FaceTools::SurfaceDataArchive;
 using FaceTools::FM;
 
-std::unordered_map<const FM*, FMC::Ptr> FaceModelCurvatureStore::_metrics;
+std::unordered_map<const FM*, FaceModelCurvatureStore::Entry::Ptr> FaceModelCurvatureStore::_metrics;
+std::unordered_set<const FM*> FaceModelCurvatureStore::_evicted;
 QReadWriteLock FaceModelCurvatureStore::_lock;
 
 
-FaceModelCurvatureStore::RPtr FaceModelCurvatureStore::rvals( const FM &fm)
+int FaceModelCurvatureStore::_storeId()
 {
-    if ( !_lock.tryLockForRead())
-        return nullptr;
-    const FMC *fmc = _metrics.count(&fm) > 0 ?  _metrics.at(&fm).get() : nullptr;
-    if ( !fmc)
+    static const int sid = SDB::addStore( name(), []( const FM *fm, const FM*)
+    {
+        QWriteLocker lock( &_lock);
+        if ( _metrics.count(fm) > 0)
+        {
+            Entry::Ptr e = _metrics.at(fm);
+            if ( !e->lock.tryLockForWrite())  // In use
+                return false;
+            _metrics.erase(fm);
+            _evicted.insert(fm);
+            e->lock.unlock();
+        }   // end if
+        return true;
+    });
+    return sid;
+}   // end _storeId
+
+
+FaceModelCurvatureStore::Entry::Ptr FaceModelCurvatureStore::_entry( const FM &fm)
+{
+    _lock.lockForRead();
+    Entry::Ptr e = _metrics.count(&fm) > 0 ? _metrics.at(&fm) : nullptr;
+    bool evicted = !e && _evicted.count(&fm) > 0;
+    _lock.unlock();
+    if ( evicted)  // Request recalculation (just once) and return null until it's done
     {
+        _lock.lockForWrite();
+        evicted = _evicted.erase(&fm) > 0;
         _lock.unlock();
-        return nullptr;
+        if ( evicted)
+            SDB::recalculate( _storeId(), &fm, nullptr);
     }   // end if
-    return RPtr( fmc, []( const FMC*){ _lock.unlock();});
+    if ( e)
+        SDB::touch( _storeId(), &fm, nullptr);
+    return e;
+}   // end _entry
+
+
+FaceModelCurvatureStore::RPtr FaceModelCurvatureStore::rvals( const FM &fm)
+{
+    Entry::Ptr e = _entry( fm);
+    if ( !e || !e->lock.tryLockForRead())
+        return nullptr;
+    // The entry is kept alive (even if purged or replaced) until the returned pointer dies.
+    return RPtr( e->data.get(), [e]( const FMC*){ e->lock.unlock();});
 }   // end rvals
 
 
 FaceModelCurvatureStore::WPtr FaceModelCurvatureStore::wvals( const FM &fm)
 {
-    _lock.lockForWrite();
-    FMC *fmc = _metrics.count(&fm) > 0 ?  _metrics.at(&fm).get() : nullptr;
-    if ( !fmc)
-    {
-        _lock.unlock();
+    Entry::Ptr e = _entry( fm);
+    if ( !e)
         return nullptr;
-    }   // end if
-    return WPtr( fmc, []( const FMC*){ _lock.unlock();});
+    e->lock.lockForWrite();
+    return WPtr( e->data.get(), [e]( const FMC*){ e->lock.unlock();});
 }   // end wvals
 
 
@@ -56,15 +94,31 @@ void FaceModelCurvatureStore::purge( const FM &fm)
 {
     _lock.lockForWrite();
     _metrics.erase(&fm);
+    _evicted.erase(&fm);
     _lock.unlock();
+    SDB::remove( _storeId(), &fm, nullptr);
 }   // end purge
 
 
+QString FaceModelCurvatureStore::name() { return "Curvature";}
+
+
+size_t FaceModelCurvatureStore::contentHash( const FM &fm) { return SurfaceDataArchive::meshHash( fm.mesh());}
+
+
 void FaceModelCurvatureStore::add( const FM &fm)
 {
-    FMC::Ptr fmc = FMC::create( fm.mesh());  // Blocks
+    const Trace::Scope trace( "store", "FaceModelCurvatureStore::add");
+    FMC::Ptr fmc;
+    SurfaceDataArchive::Arrays arrs;
+    if ( SurfaceDataArchive::take( &fm, name(), contentHash( fm), arrs))
+        fmc = FMC::create( fm.mesh(), arrs);
+    if ( !fmc)
+        fmc = FMC::create( fm.mesh());  // Blocks (without holding any lock)
+    const size_t nbytes = fmc->memoryUsage();
     _lock.lockForWrite();
-    assert( _metrics.count(&fm) == 0);
-    _metrics[&fm] = fmc;
+    _metrics[&fm] = Entry::create( fmc);
+    _evicted.erase(&fm);
     _lock.unlock();
+    SDB::add( _storeId(), &fm, nullptr, nbytes);
 }   // end add
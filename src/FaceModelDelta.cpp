@@ -17,9 +17,12 @@
 
 #include <FaceTools/FaceModelDelta.h>
 #include <FaceTools/FaceModel.h>
+#include <FaceTools.h>
+#include <FaceTools/SurfaceDataBudget.h>
 #include <r3d/SurfacePointFinder.h>
 #include <r3d/ProcrustesSuperimposition.h>
 #include <r3dvis/SurfaceMapper.h>
+#include <algorithm>
 #include <cassert>
 using FaceTools::FaceModelDelta;
 using FaceTools::FM;
@@ -62,50 +65,63 @@ FaceModelDelta::Ptr FaceModelDelta::create( const FM *tgt, const FM *src)
         assert(false);
         return nullptr;
     }   // end if
-    return Ptr( new FaceModelDelta( tgt, src), []( const FaceModelDelta *d){ delete d;});
+    Ptr fmd( new FaceModelDelta( tgt, src), []( const FaceModelDelta *d){ delete d;});
+    if ( TaskState::cancelled())
+        fmd = nullptr;
+    return fmd;
 }   // end create
 
 
 FaceModelDelta::FaceModelDelta( const FM *fmt, const FM *fms) : _tgt(fmt), _src(fms)
 {
     _asmsk = calcAlignedSourceMask( fmt->mask(), fms->mask());
-    _calcMaskVtxVals();
-    _calcTargetMeshVtxVals();
+    TaskState *ts = TaskState::current();
+    _calcMaskVtxVals( ts);
+    _calcTargetMeshVtxVals( ts);
+    if ( ts && ts->isCancelled())
+        return; // Discarded by create
     using VSM = r3dvis::VertexSurfaceMapper;
 
     // Make the source mask vector array. Note that the scalars array contains negative values
     // which will flip the direction of those difference vectors so we negate those ones.
     _vecsArr = VSM( [this](int vid, size_t k)
                     {
-                        const float neg = copysignf( 1.0f, _maskVtxVals.at(vid).scalars[2]);
-                        return neg * _maskVtxVals.at(vid).dvector[k];
+                        const float neg = copysignf( 1.0f, _maskVtxVals[vid].scalars[2]);
+                        return neg * _maskVtxVals[vid].dvector[k];
                     }, 3).makeArrayNoTx( *_asmsk, "FaceModelDelta_Vectors");
 
     // Make the source mask scalars array (contains negative values!)
     _sclsArr = VSM( [this](int vid, size_t)
-            { return _maskVtxVals.at(vid).scalars[2];}, 1).makeArrayNoTx( *_asmsk, "FaceModelDelta_Scalars");
+            { return _maskVtxVals[vid].scalars[2];}, 1).makeArrayNoTx( *_asmsk, "FaceModelDelta_Scalars");
 
     // Make the scalar arrays
     const r3d::Mesh &mesh = _tgt->mesh();
     _perpArr = VSM( [this](int vid, size_t)
-                   { return _targVtxVals.at(vid)[0];}, 1).makeArray( mesh, "FaceModelDelta_Perpendicular");
+                   { return _targVtxVals[vid][0];}, 1).makeArray( mesh, "FaceModelDelta_Perpendicular");
     _angdArr = VSM( [this](int vid, size_t)
-                   { return _targVtxVals.at(vid)[1];}, 1).makeArray( mesh, "FaceModelDelta_Angular");
+                   { return _targVtxVals[vid][1];}, 1).makeArray( mesh, "FaceModelDelta_Angular");
     _smagArr = VSM( [this](int vid, size_t)
-                   { return _targVtxVals.at(vid)[2];}, 1).makeArray( mesh, "FaceModelDelta_SignedMag");
+                   { return _targVtxVals[vid][2];}, 1).makeArray( mesh, "FaceModelDelta_SignedMag");
 }   // end ctor
 
 
 FaceModelDelta::~FaceModelDelta() {}
 
 
-void FaceModelDelta::_calcMaskVtxVals()
+void FaceModelDelta::_calcMaskVtxVals( TaskState *ts)
 {
     const r3d::Mesh &tmsk = _tgt->mask();  // Original mask from the target model
     const r3d::Mesh &asmsk = *_asmsk;
-    for ( int vidx : tmsk.vtxIds())
+    const size_t N = tmsk.numVtxs();   // Mask vertex IDs are sequential
+    _maskVtxVals.resize(N);
+    if ( ts)
+        ts->addSteps(N);
+    parallelFor( N, [&]( size_t i)
     {
-        VtxVals &vvals = _maskVtxVals[vidx];
+        if ( ts && ts->poll(i))
+            return;
+        const int vidx = int(i);
+        VtxVals &vvals = _maskVtxVals[i];
         vvals.dvector = tmsk.uvtx( vidx) - asmsk.uvtx( vidx);
         const Vec3f &dv = vvals.dvector;
 
@@ -114,19 +130,33 @@ void FaceModelDelta::_calcMaskVtxVals()
         vvals.scalars[0] = dp;
         vvals.scalars[1] = (dv - dp * snrm).norm();  // Transverse difference
         vvals.scalars[2] = copysignf( 1.0f, dp) * dv.norm();   // Signed total change
-    }   // end for
+    });
+    if ( ts)
+        ts->advance( N % 0x100);
 }   // end _calcMaskVtxVals
 
 
-void FaceModelDelta::_calcTargetMeshVtxVals()
+void FaceModelDelta::_calcTargetMeshVtxVals( TaskState *ts)
 {
+    if ( ts && ts->isCancelled())
+        return;
+
     const r3d::Mesh &mesh = _tgt->mesh();
     const r3d::Mesh &mask = _tgt->mask();
     const r3d::KDTree &mkdt = _tgt->maskKDTree();
     const r3d::SurfacePointFinder maskPointFinder( mask);
 
-    for ( int vidx : mesh.vtxIds())
+    const std::vector<int> vidxs( mesh.vtxIds().begin(), mesh.vtxIds().end());
+    const int maxId = vidxs.empty() ? -1 : *std::max_element( vidxs.begin(), vidxs.end());
+    _targVtxVals.assign( size_t(maxId + 1), Vec3f::Zero());
+
+    if ( ts)
+        ts->addSteps( vidxs.size());
+    parallelFor( vidxs.size(), [&]( size_t i)
     {
+        if ( ts && ts->poll(i))
+            return;
+        const int vidx = vidxs[i];
         const Vec3f &p = mesh.uvtx(vidx);    // Original vertex on target to which we're mapping differences
         // Find pm as mask position that p is closest to and fid as the triangle it's in:
         Vec3f pm;
@@ -138,7 +168,7 @@ void FaceModelDelta::_calcTargetMeshVtxVals()
         {
             assert( pvidx >= 0);
             assert( pm == mask.uvtx(pvidx));
-            _targVtxVals[vidx] = _maskVtxVals.at(pvidx).scalars;
+            _targVtxVals[vidx] = _maskVtxVals[pvidx].scalars;
         }   // end if
         else
         {
@@ -146,9 +176,22 @@ void FaceModelDelta::_calcTargetMeshVtxVals()
             // Find the barycentric values
             const Vec3f bm = mask.toBarycentric( fid, pm);
             const int *fvidxs = mask.fvidxs(fid);
-            _targVtxVals[vidx] = bm[0]*_maskVtxVals.at(fvidxs[0]).scalars
-                               + bm[1]*_maskVtxVals.at(fvidxs[1]).scalars
-                               + bm[2]*_maskVtxVals.at(fvidxs[2]).scalars;
+            _targVtxVals[vidx] = bm[0]*_maskVtxVals[fvidxs[0]].scalars
+                               + bm[1]*_maskVtxVals[fvidxs[1]].scalars
+                               + bm[2]*_maskVtxVals[fvidxs[2]].scalars;
         }   // end else
-    }   // end for
+    });
+    if ( ts)
+        ts->advance( vidxs.size() % 0x100);
 }   // end _calcTargetMeshVtxVals
+
+
+size_t FaceModelDelta::memoryUsage() const
+{
+    using SDB = SurfaceDataBudget;
+    size_t nbytes = SDB::bytes( *_asmsk);
+    nbytes += _maskVtxVals.capacity() * sizeof(VtxVals) + _targVtxVals.capacity() * sizeof(Vec3f);
+    nbytes += SDB::bytes( _perpArr) + SDB::bytes( _angdArr) + SDB::bytes( _smagArr);
+    nbytes += SDB::bytes( _vecsArr) + SDB::bytes( _sclsArr);
+    return nbytes;
+}   // end memoryUsage
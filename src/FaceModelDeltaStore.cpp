@@ -17,76 +17,138 @@
 
 #include <FaceTools/FaceModelDeltaStore.h>
 #include <FaceTools/FaceModel.h>
+#include <FaceTools/Trace.h>
 #include <cassert>
 using FaceTools::FaceModelDeltaStore;
 using FMD = FaceTools::FaceModelDelta;
+using SDB = FaceTools::SurfaceDataBudget;
 using FaceTools::FM;
 
 
-std::unordered_map<const FM*, std::unordered_map<const FM*, FMD::Ptr> > FaceModelDeltaStore::_t2s;
-std::unordered_map<const FM*, std::unordered_map<const FM*, FMD::Ptr> > FaceModelDeltaStore::_s2t;
+std::unordered_map<const FM*, std::unordered_map<const FM*, FaceModelDeltaStore::Entry::Ptr> > FaceModelDeltaStore::_t2s;
+std::unordered_map<const FM*, std::unordered_map<const FM*, FaceModelDeltaStore::Entry::Ptr> > FaceModelDeltaStore::_s2t;
+std::set<std::pair<const FM*, const FM*> > FaceModelDeltaStore::_evicted;
 QReadWriteLock FaceModelDeltaStore::_lock;
 
 
+int FaceModelDeltaStore::_storeId()
+{
+    static const int sid = SDB::addStore( name(), []( const FM *tgt, const FM *src)
+    {
+        QWriteLocker lock( &_lock);
+        if ( _has( tgt, src))
+        {
+            Entry::Ptr e = _t2s.at(tgt).at(src);
+            if ( !e->lock.tryLockForWrite())  // In use
+                return false;
+            _erase( tgt, src);
+            _evicted.insert( std::make_pair( tgt, src));
+            e->lock.unlock();
+        }   // end if
+        return true;
+    });
+    return sid;
+}   // end _storeId
+
+
 bool FaceModelDeltaStore::_has( const FM *tgt, const FM *src)
 {
     return _t2s.count(tgt) > 0 && _t2s.at(tgt).count(src) > 0;
 }   // end _has
 
 
+void FaceModelDeltaStore::_erase( const FM *tgt, const FM *src)
+{
+    if ( _t2s.count(tgt) > 0)
+    {
+        _t2s.at(tgt).erase(src);
+        if ( _t2s.at(tgt).empty())
+            _t2s.erase(tgt);
+    }   // end if
+    if ( _s2t.count(src) > 0)
+    {
+        _s2t.at(src).erase(tgt);
+        if ( _s2t.at(src).empty())
+            _s2t.erase(src);
+    }   // end if
+}   // end _erase
+
+
+QString FaceModelDeltaStore::name() { return "Delta";}
+
+
 using RPtr = std::shared_ptr<const FMD>;
 RPtr FaceModelDeltaStore::vals( const FM *tgt, const FM *src)
 {
-    if ( !_lock.tryLockForRead())
-        return nullptr;
-    if ( !_has(tgt, src))
+    _lock.lockForRead();
+    Entry::Ptr e = _has( tgt, src) ? _t2s.at(tgt).at(src) : nullptr;
+    bool evicted = !e && _evicted.count( std::make_pair( tgt, src)) > 0;
+    _lock.unlock();
+    if ( evicted)  // Request recalculation (just once) and return null until it's done
     {
+        _lock.lockForWrite();
+        evicted = _evicted.erase( std::make_pair( tgt, src)) > 0;
         _lock.unlock();
-        return nullptr;
+        if ( evicted)
+            SDB::recalculate( _storeId(), tgt, src);
     }   // end if
-    return RPtr( _t2s.at(tgt).at(src).get(), []( const FMD*){ _lock.unlock();});
+
+    if ( !e || !e->lock.tryLockForRead())
+        return nullptr;
+    SDB::touch( _storeId(), tgt, src);
+    // The entry is kept alive (even if purged or replaced) until the returned pointer dies.
+    return RPtr( e->data.get(), [e]( const FMD*){ e->lock.unlock();});
 }   // end vals
 
 
 void FaceModelDeltaStore::add( const FM *tgt, const FM *src)
 {
+    const Trace::Scope trace( "store", "FaceModelDeltaStore::add");
+    FMD::Ptr fmd = FMD::create( tgt, src);  // Blocks (computed without holding the lock)
+    if ( !fmd)  // Cancelled
+        return;
+    const size_t nbytes = fmd->memoryUsage();
+    const Entry::Ptr e = Entry::create( fmd);
     _lock.lockForWrite();
-    FMD::Ptr fmd = FMD::create( tgt, src);
-    assert(fmd);
-    _t2s[tgt][src] = fmd;
-    _s2t[src][tgt] = fmd;
+    _t2s[tgt][src] = e;
+    _s2t[src][tgt] = e;
+    _evicted.erase( std::make_pair( tgt, src));
     _lock.unlock();
+    SDB::add( _storeId(), tgt, src, nbytes);
 }   // end add
 
 
 bool FaceModelDeltaStore::has( const FM *tgt, const FM *src)
 {
-    if ( !_lock.tryLockForRead())
-        return false;
-    const bool h = _has( tgt, src);
-    _lock.unlock();
-    return h;
+    QReadLocker lock( &_lock);
+    return _has( tgt, src) || _evicted.count( std::make_pair( tgt, src)) > 0;
 }   // end has
 
 
 void FaceModelDeltaStore::purge( const FM *fm)
 {
+    std::vector<std::pair<const FM*, const FM*> > pairs;    // Target/source pairs purged
     _lock.lockForWrite();
     // All the targets using fm as a source need purging
     if ( _s2t.count(fm) > 0)
-    {
         for ( const auto& p : _s2t.at(fm))
-        {
-            const FM *tgt = p.first;
-            if ( _t2s.count(tgt) > 0)
-            {
-                _t2s.at(tgt).erase(fm);
-                if ( _t2s.at(tgt).empty())
-                    _t2s.erase(tgt);
-            }   // end if
-        }   // end for
-        _s2t.erase(fm);
-    }   // end if
-    _t2s.erase(fm);
+            pairs.push_back( std::make_pair( p.first, fm));
+    // As well as all the sources for fm as a target
+    if ( _t2s.count(fm) > 0)
+        for ( const auto& p : _t2s.at(fm))
+            pairs.push_back( std::make_pair( fm, p.first));
+    for ( const auto &p : pairs)
+        _erase( p.first, p.second);
+
+    for ( auto it = _evicted.begin(); it != _evicted.end();)
+    {
+        if ( it->first == fm || it->second == fm)
+            it = _evicted.erase(it);
+        else
+            ++it;
+    }   // end for
     _lock.unlock();
+
+    for ( const auto &p : pairs)
+        SDB::remove( _storeId(), p.first, p.second);
 }   // end purge
@@ -18,8 +18,11 @@
 #include <FaceTools/FaceModelSymmetry.h>
 #include <FaceTools/MaskRegistration.h>
 #include <FaceTools/FaceModel.h>
+#include <FaceTools.h>
+#include <FaceTools/SurfaceDataBudget.h>
 #include <r3dvis/SurfaceMapper.h>
 #include <r3d/SurfacePointFinder.h>
+#include <algorithm>
 #include <cassert>
 using FaceTools::FaceModelSymmetry;
 using FaceTools::FM;
@@ -28,7 +31,32 @@ using FaceTools::FM;
 FaceModelSymmetry::Ptr FaceModelSymmetry::create( const FM *fm)
 {
     assert( fm->hasMask());
-    return Ptr( new FaceModelSymmetry( fm), []( const FaceModelSymmetry *d){ delete d;});
+    Ptr fms( new FaceModelSymmetry( fm), []( const FaceModelSymmetry *d){ delete d;});
+    if ( TaskState::cancelled())
+        fms = nullptr;
+    return fms;
+}   // end create
+
+
+FaceModelSymmetry::Ptr FaceModelSymmetry::create( const FM *fm, const std::vector<vtkSmartPointer<vtkFloatArray> > &arrs)
+{
+    const vtkIdType nv = vtkIdType( fm->mesh().numVtxs());
+    if ( arrs.size() != 4)
+        return nullptr;
+    for ( const vtkSmartPointer<vtkFloatArray> &arr : arrs)
+        if ( !arr || arr->GetNumberOfTuples() != nv || arr->GetNumberOfComponents() != 1)
+            return nullptr;
+
+    Ptr fms( new FaceModelSymmetry, []( const FaceModelSymmetry *d){ delete d;});
+    fms->_xarr = arrs[0];
+    fms->_yarr = arrs[1];
+    fms->_zarr = arrs[2];
+    fms->_allarr = arrs[3];
+    fms->_xarr->SetName("FaceModelSymmetry_X");
+    fms->_yarr->SetName("FaceModelSymmetry_Y");
+    fms->_zarr->SetName("FaceModelSymmetry_Z");
+    fms->_allarr->SetName("FaceModelSymmetry_All");
+    return fms;
 }   // end create
 
 
@@ -37,31 +65,44 @@ FaceModelSymmetry::~FaceModelSymmetry(){}
 
 FaceModelSymmetry::FaceModelSymmetry( const FM *fm)
 {
-    _makeVtxSymm( fm);
+    _makeVtxSymm( fm, TaskState::current());
+    if ( TaskState::cancelled())
+        return; // Discarded by create
     const r3d::Mesh &mesh = fm->mesh();
     using VSM = r3dvis::VertexSurfaceMapper;
-    _xarr = VSM( [this]( int i, size_t){ return _vtxSymm.at(i)[0];}, 1).makeArray( mesh, "FaceModelSymmetry_X");
-    _yarr = VSM( [this]( int i, size_t){ return _vtxSymm.at(i)[1];}, 1).makeArray( mesh, "FaceModelSymmetry_Y");
-    _zarr = VSM( [this]( int i, size_t){ return _vtxSymm.at(i)[2];}, 1).makeArray( mesh, "FaceModelSymmetry_Z");
-    _allarr = VSM( [this]( int i, size_t){ return _vtxSymm.at(i)[3];}, 1).makeArray( mesh, "FaceModelSymmetry_All");
+    _xarr = VSM( [this]( int i, size_t){ return _vtxSymm[i][0];}, 1).makeArray( mesh, "FaceModelSymmetry_X");
+    _yarr = VSM( [this]( int i, size_t){ return _vtxSymm[i][1];}, 1).makeArray( mesh, "FaceModelSymmetry_Y");
+    _zarr = VSM( [this]( int i, size_t){ return _vtxSymm[i][2];}, 1).makeArray( mesh, "FaceModelSymmetry_Z");
+    _allarr = VSM( [this]( int i, size_t){ return _vtxSymm[i][3];}, 1).makeArray( mesh, "FaceModelSymmetry_All");
 }   // end ctor
 
 
-void FaceModelSymmetry::_makeVtxSymm( const FM *fm)
+void FaceModelSymmetry::_makeVtxSymm( const FM *fm, TaskState *ts)
 {
     const r3d::Mesh &mesh = fm->mesh();
     const r3d::Mesh &mask = fm->mask();
     const r3d::KDTree &mkdt = fm->maskKDTree();
 
     const r3d::SurfacePointFinder maskPointFinder( mask);
-    const std::unordered_map<int,int>& maskOppVtxs = MaskRegistration::maskData()->oppVtxs;
+    // Hold the mask data (and its read lock) for the duration
+    const MaskRegistration::MaskPtr mdata = MaskRegistration::maskData();
+    const std::vector<int>& maskOppVtxs = mdata->oppVtxs;
 
     const Mat4f T = fm->transformMatrix();
-    Vec3f u = T.block<3,1>(0,0);
-    Vec3f m = T.block<3,1>(0,3);
+    const Vec3f u = T.block<3,1>(0,0);
+    const Vec3f m = T.block<3,1>(0,3);
 
-    for ( int vidx : mesh.vtxIds())
+    const std::vector<int> vidxs( mesh.vtxIds().begin(), mesh.vtxIds().end());
+    const int maxId = vidxs.empty() ? -1 : *std::max_element( vidxs.begin(), vidxs.end());
+    _vtxSymm.assign( size_t(maxId + 1), Vec4f::Zero());
+
+    if ( ts)
+        ts->addSteps( vidxs.size());
+    parallelFor( vidxs.size(), [&]( size_t i)
     {
+        if ( ts && ts->poll(i))
+            return;
+        const int vidx = vidxs[i];
         const Vec3f &p = mesh.vtx(vidx);    // Original vertex on the model
 
         // Find pm as the position on the mask that vertex p is closest to and mt as the triangle it's within:
@@ -75,7 +116,7 @@ void FaceModelSymmetry::_makeVtxSymm( const FM *fm)
         {
             assert( pvidx >= 0);
             assert( pm == mask.vtx(pvidx));
-            qm = mask.vtx(maskOppVtxs.at(pvidx));
+            qm = mask.vtx(maskOppVtxs[pvidx]);
         }   // end if
         else
         {
@@ -87,12 +128,10 @@ void FaceModelSymmetry::_makeVtxSymm( const FM *fm)
             // the normal still pointing out from the face.
             const int *fvidxs = mask.fvidxs(mt);
             assert(fvidxs);
-            assert( maskOppVtxs.count(fvidxs[0]) > 0);
-            assert( maskOppVtxs.count(fvidxs[1]) > 0);
-            assert( maskOppVtxs.count(fvidxs[2]) > 0);
-            const int v0 = maskOppVtxs.at(fvidxs[0]);
-            const int v1 = maskOppVtxs.at(fvidxs[1]);
-            const int v2 = maskOppVtxs.at(fvidxs[2]);
+            const int v0 = maskOppVtxs[fvidxs[0]];
+            const int v1 = maskOppVtxs[fvidxs[1]];
+            const int v2 = maskOppVtxs[fvidxs[2]];
+            assert( v0 >= 0 && v1 >= 0 && v2 >= 0);
             qm = bm[0]*mask.vtx(v0) + bm[1]*mask.vtx(v1) + bm[2]*mask.vtx(v2);
         }   // end else
 
@@ -115,5 +154,16 @@ void FaceModelSymmetry::_makeVtxSymm( const FM *fm)
         // Find the magnitude of difference of the anthropometrically mapped symmetric point (qm)
         // with the expected perfectly laterally symmetric point pmr and multiply this by the sign above.
         vals[3] = sgn * pmr2qm.norm();    // Signed disparity of surface to reflected point
-    }   // end for
+    });
+    if ( ts)
+        ts->advance( vidxs.size() % 0x100);
 }   // end _makeVtxSymm
+
+
+size_t FaceModelSymmetry::memoryUsage() const
+{
+    using SDB = SurfaceDataBudget;
+    size_t nbytes = _vtxSymm.capacity() * sizeof(Vec4f);
+    nbytes += SDB::bytes( _xarr) + SDB::bytes( _yarr) + SDB::bytes( _zarr) + SDB::bytes( _allarr);
+    return nbytes;
+}   // end memoryUsage
@@ -16,40 +16,72 @@
  ************************************************************************/
 
 #include <FaceTools/FaceModelSymmetryStore.h>
+#include <FaceTools/SurfaceDataArchive.h>
+#include <FaceTools/Trace.h>
+#include <FaceTools/MaskRegistration.h>
 #include <FaceTools/FaceModel.h>
+#include <boost/functional/hash.hpp>
 #include <cassert>
 using FaceTools::FaceModelSymmetryStore;
 using FaceTools::FaceModelSymmetry;
+using SDB = FaceTools::SurfaceDataBudget;
+using FaceTools::SurfaceDataArchive;
 using FaceTools::FM;
 
-std::unordered_map<const FM*, FaceModelSymmetry::Ptr> FaceModelSymmetryStore::_vtxSymm;
+std::unordered_map<const FM*, FaceModelSymmetryStore::Entry::Ptr> FaceModelSymmetryStore::_vtxSymm;
+std::unordered_set<const FM*> FaceModelSymmetryStore::_evicted;
 QReadWriteLock FaceModelSymmetryStore::_lock;
 
+
+int FaceModelSymmetryStore::_storeId()
+{
+    static const int sid = SDB::addStore( name(), []( const FM *fm, const FM*)
+    {
+        QWriteLocker lock( &_lock);
+        if ( _vtxSymm.count(fm) > 0)
+        {
+            Entry::Ptr e = _vtxSymm.at(fm);
+            if ( !e->lock.tryLockForWrite())  // In use
+                return false;
+            _vtxSymm.erase(fm);
+            _evicted.insert(fm);
+            e->lock.unlock();
+        }   // end if
+        return true;
+    });
+    return sid;
+}   // end _storeId
+
+
 using RPtr = std::shared_ptr<const FaceModelSymmetry>;
 RPtr FaceModelSymmetryStore::vals( const FM *fm)
 {
-    if ( !_lock.tryLockForRead())
-        return nullptr;
-    const FaceModelSymmetry *vvals = _vtxSymm.count(fm) > 0 ? _vtxSymm.at(fm).get() : nullptr;
-    if ( !vvals)
+    _lock.lockForRead();
+    Entry::Ptr e = _vtxSymm.count(fm) > 0 ? _vtxSymm.at(fm) : nullptr;
+    bool evicted = !e && _evicted.count(fm) > 0;
+    _lock.unlock();
+    if ( evicted)  // Request recalculation (just once) and return null until it's done
     {
+        _lock.lockForWrite();
+        evicted = _evicted.erase(fm) > 0;
         _lock.unlock();
-        return nullptr;
+        if ( evicted)
+            SDB::recalculate( _storeId(), fm, nullptr);
     }   // end if
-    return RPtr( vvals, []( const FaceModelSymmetry*){ _lock.unlock();});
+
+    if ( !e || !e->lock.tryLockForRead())
+        return nullptr;
+    SDB::touch( _storeId(), fm, nullptr);
+    // The entry is kept alive (even if purged or replaced) until the returned pointer dies.
+    return RPtr( e->data.get(), [e]( const FaceModelSymmetry*){ e->lock.unlock();});
 }   // end vals
 
 
 bool FaceModelSymmetryStore::isMapped( const FM *fm)
 {
     assert( fm);
-    bool gotvals = false;
-    if ( _lock.tryLockForRead())
-    {
-        gotvals = _vtxSymm.count(fm) > 0;
-        _lock.unlock(); 
-    }   // end if
-    return gotvals;
+    QReadLocker lock( &_lock);
+    return _vtxSymm.count(fm) > 0 || _evicted.count(fm) > 0;
 }   // end isMapped
 
 
@@ -57,14 +89,42 @@ void FaceModelSymmetryStore::purge( const FM *fm)
 {
     _lock.lockForWrite();
     _vtxSymm.erase(fm);
+    _evicted.erase(fm);
     _lock.unlock();
+    SDB::remove( _storeId(), fm, nullptr);
 }   // end purge
 
 
+QString FaceModelSymmetryStore::name() { return "Symmetry";}
+
+
+size_t FaceModelSymmetryStore::contentHash( const FM *fm)
+{
+    size_t h = SurfaceDataArchive::meshHash( fm->mesh());
+    if ( h != 0)
+    {
+        boost::hash_combine( h, fm->maskHash());
+        boost::hash_combine( h, MaskRegistration::maskHash());
+    }   // end if
+    return h;
+}   // end contentHash
+
+
 void FaceModelSymmetryStore::add( const FM *fm)
 {
-    assert( _vtxSymm.count(fm) == 0);
+    const Trace::Scope trace( "store", "FaceModelSymmetryStore::add");
+    FaceModelSymmetry::Ptr vsymm;
+    SurfaceDataArchive::Arrays arrs;
+    if ( SurfaceDataArchive::take( fm, name(), contentHash( fm), arrs))
+        vsymm = FaceModelSymmetry::create( fm, arrs);
+    if ( !vsymm)
+        vsymm = FaceModelSymmetry::create(fm);  // Blocks (without holding any lock)
+    if ( !vsymm)    // Cancelled
+        return;
+    const size_t nbytes = vsymm->memoryUsage();
     _lock.lockForWrite();
-    _vtxSymm[fm] = FaceModelSymmetry::create(fm);
+    _vtxSymm[fm] = Entry::create( vsymm);
+    _evicted.erase(fm);
     _lock.unlock();
+    SDB::add( _storeId(), fm, nullptr, nbytes);
 }   // end add
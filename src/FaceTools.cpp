@@ -24,13 +24,77 @@
 #include <r3d/SurfacePlanarPathFinder.h>
 #include <r3d/SurfacePointFinder.h>
 #include <r3d/SurfaceCurveFinder.h>
+#include <QThreadPool>
+#include <QRunnable>
 #include <algorithm>
+#include <condition_variable>
+#include <atomic>
+#include <thread>
+#include <mutex>
 using FaceTools::FM;
 using namespace r3d;
 
 
 namespace {
 
+// Blocks of a parallelFor claimed by whichever thread gets to them first (the calling thread included).
+// Shared with the pool tasks since these may only start after the parallelFor has returned.
+struct ParallelBlocks
+{
+    ParallelBlocks( size_t n, size_t nb, const std::function<void( size_t)> &f)
+        : n(n), bsz((n + nb - 1) / nb), nblocks(nb), fn(f), next(0), ndone(0) {}
+
+    // Run blocks until none remain unclaimed.
+    void run()
+    {
+        for ( size_t b = next++; b < nblocks; b = next++)
+        {
+            const size_t i1 = std::min( n, (b+1) * bsz);
+            for ( size_t i = b * bsz; i < i1; ++i)
+                fn(i);
+            std::lock_guard<std::mutex> lock( mutex);
+            if ( ++ndone == nblocks)
+                cv.notify_all();
+        }   // end for
+    }   // end run
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock( mutex);
+        cv.wait( lock, [this](){ return ndone == nblocks;});
+    }   // end wait
+
+    const size_t n, bsz, nblocks;
+    const std::function<void( size_t)> &fn; // Only called while the parallelFor is waiting
+    std::atomic<size_t> next;
+    size_t ndone;
+    std::mutex mutex;
+    std::condition_variable cv;
+};  // end struct
+
+
+class ParallelTask : public QRunnable
+{
+public:
+    explicit ParallelTask( const std::shared_ptr<ParallelBlocks> &pb) : _pb(pb) { setAutoDelete(true);}
+    void run() override { _pb->run();}
+private:
+    std::shared_ptr<ParallelBlocks> _pb;
+};  // end class
+
+
+QThreadPool* parallelPool()
+{
+    static QThreadPool *pool = nullptr;
+    static std::once_flag once;
+    std::call_once( once, [](){
+        pool = new QThreadPool;
+        pool->setMaxThreadCount( int(std::max<unsigned>( 1, std::thread::hardware_concurrency())));
+        pool->setExpiryTimeout(-1);    // Threads persist
+    });
+    return pool;
+}   // end parallelPool
+
 void updateNormal( const KDTree &kdt, const Vec3f& v0, const Vec3f& v1, Vec3f& nvec)
 {
     // Estimate "down" vector from cross product of base vector with current (inaccurate) face normal.
@@ -191,3 +255,26 @@ QColor FaceTools::chooseContrasting( const QColor& a)
         b = Qt::white;
     return b;
 }   // end chooseContrasting
+
+
+void FaceTools::parallelFor( size_t n, const std::function<void( size_t)> &fn, size_t minBlock)
+{
+    const size_t hwt = std::max<size_t>( 1, std::thread::hardware_concurrency());
+    const size_t nthreads = std::min( hwt, n / std::max<size_t>( 1, minBlock));
+    if ( nthreads <= 1)
+    {
+        for ( size_t i = 0; i < n; ++i)
+            fn(i);
+        return;
+    }   // end if
+
+    // The calling thread claims blocks too so progress never depends on the pool having free
+    // threads. Nested calls (from pool workers) and a saturated pool therefore can't deadlock,
+    // and the pool's fixed size bounds the number of threads across concurrent calls.
+    const std::shared_ptr<ParallelBlocks> pb = std::make_shared<ParallelBlocks>( n, nthreads, fn);
+    QThreadPool *pool = parallelPool();
+    for ( size_t t = 1; t < nthreads; ++t)
+        pool->start( new ParallelTask( pb));
+    pb->run();
+    pb->wait();
+}   // end parallelFor
@@ -0,0 +1,168 @@
+/************************************************************************
+ * Copyright (C) 2021 SIS Research Ltd & Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#include <FileIO/BatchProcessor.h>
+#include <FileIO/FaceModelFileData.h>
+#include <Action/ActionDetectFace.h>
+#include <Action/ActionExtractFace.h>
+#include <Action/ActionUpdateMeasurements.h>
+#include <LndMrk/LandmarksManager.h>
+#include <Metric/PhenotypeManager.h>
+#include <Metric/MetricManager.h>
+#include <Metric/StatsManager.h>
+#include <FaceModelCurvatureStore.h>
+#include <MaskRegistration.h>
+#include <FaceModel.h>
+#include <FaceTools.h>
+#include <QFileInfo>
+#include <QDir>
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+using FaceTools::FileIO::BatchProcessor;
+using FaceTools::FM;
+using FMM = FaceTools::FileIO::FaceModelManager;
+using FMCS = FaceTools::FaceModelCurvatureStore;
+using LMAN = FaceTools::Landmark::LandmarksManager;
+using MM = FaceTools::Metric::MetricManager;
+using SM = FaceTools::Metric::StatsManager;
+using PM = FaceTools::Metric::PhenotypeManager;
+
+
+BatchProcessor::BatchProcessor( const QString &outdir)
+    : _outdir( QFileInfo(outdir).absoluteFilePath()), _detect(true), _extract(true), _writeCSV(true)
+{
+    QDir().mkpath( _outdir);
+}   // end ctor
+
+
+bool BatchProcessor::isValid() const
+{
+    const QFileInfo finfo( _outdir);
+    return finfo.isDir() && finfo.isWritable();
+}   // end isValid
+
+
+BatchProcessor::Result BatchProcessor::process( const QString &fpath) const
+{
+    Result res;
+    res.inpath = fpath;
+    res.nhpos = 0;
+
+    FM *fm = FMM::read( fpath);
+    if ( !fm)
+    {
+        res.err = FMM::error();
+        return res;
+    }   // end if
+
+    res.err = _process( *fm, res);
+    if ( !res.err.isEmpty())
+        res.outpath = "";
+
+    // Release everything associated with the model
+    MM::purge( fm);
+    SM::purge( *fm);
+    FMCS::purge( *fm);
+    FMM::close( *fm);
+    return res;
+}   // end process
+
+
+QString BatchProcessor::_process( FM &fm, Result &res) const
+{
+    FMCS::add( fm);    // Needed for alignment and the vertex normals
+
+    if ( _detect)
+    {
+        if ( !MaskRegistration::maskLoaded())
+            return "Mask not loaded!";
+        if ( !fm.mesh().hasSequentialIds())
+            return "Mesh does not have sequential vertex IDs!";
+        if ( !Action::ActionDetectFace::detect( fm, LMAN::ids(), true))
+            return "Face detection failed!";
+    }   // end if
+
+    if ( _extract)
+    {
+        r3d::Mesh::Ptr nmod = Action::ActionExtractFace::extract( fm);
+        if ( nmod && nmod->numFaces() < fm.mesh().numFaces())
+        {
+            fm.update( nmod, true, true, 1);    // Keep just one manifold
+            FMCS::purge( fm);
+            FMCS::add( fm);
+        }   // end if
+    }   // end if
+
+    SM::updateStatsForModel( fm);
+    Action::ActionUpdateMeasurements::updateAllMeasurements( &fm);
+    res.nhpos = PM::discover( fm).size();
+
+    QString outpath = QDir( _outdir).filePath( QFileInfo( res.inpath).completeBaseName() + ".3df");
+    if ( !FMM::write( fm, outpath))
+        return FMM::error();
+    res.outpath = outpath;
+
+    if ( _writeCSV)
+    {
+        const QString csvpath = QDir( _outdir).filePath( QFileInfo( res.inpath).completeBaseName() + ".csv");
+        std::ofstream ofs( csvpath.toLocal8Bit().toStdString());
+        if ( !ofs.is_open())
+            return QString( "Cannot open '%1' for writing!").arg( csvpath);
+        FaceModelFileData( fm).toCSV( ofs);
+    }   // end if
+
+    return "";
+}   // end _process
+
+
+std::vector<BatchProcessor::Result> BatchProcessor::processDirectory( const QString &indir,
+                                                                    const std::function<void( const Result&)>& cb,
+                                                                    size_t maxThreads) const
+{
+    const QDir idir( indir);
+    QStringList fpaths;
+    for ( const QString &fname : idir.entryList( QDir::Files | QDir::Readable, QDir::Name))
+    {
+        const QString fpath = idir.absoluteFilePath( fname);
+        if ( FMM::canRead( fpath))
+            fpaths.append( fpath);
+    }   // end for
+
+    const size_t N = size_t(fpaths.size());
+    std::vector<Result> results(N);
+    if ( maxThreads == 0)
+        maxThreads = N;
+
+    // As in FaceModelManager::read, files are processed in (at most maxThreads) interleaved batches.
+    const size_t nbatches = std::min( N, maxThreads);
+    std::mutex cbmutex;
+    FaceTools::parallelFor( nbatches, [&]( size_t b)
+    {
+        for ( size_t i = b; i < N; i += nbatches)
+        {
+            results[i] = process( fpaths.at(int(i)));
+            if ( cb)
+            {
+                std::lock_guard<std::mutex> lock( cbmutex);
+                cb( results[i]);
+            }   // end if
+        }   // end for
+    }, 1);
+
+    return results;
+}   // end processDirectory
@@ -0,0 +1,284 @@
+/************************************************************************
+ * Copyright (C) 2021 SIS Research Ltd & Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#include <FileIO/BinaryMesh.h>
+#include <opencv2/imgcodecs.hpp>
+#include <fstream>
+#include <cstring>
+#include <cassert>
+using r3d::Mesh;
+using r3d::Vec2f;
+using r3d::Vec3f;
+
+
+namespace {
+static const char MAGIC[4] = {'R','3','D','B'};
+
+void putU32( std::vector<char> &buf, uint32_t v)
+{
+    buf.push_back( char(v & 0xff));
+    buf.push_back( char((v >> 8) & 0xff));
+    buf.push_back( char((v >> 16) & 0xff));
+    buf.push_back( char((v >> 24) & 0xff));
+}   // end putU32
+
+void putI32( std::vector<char> &buf, int32_t v) { putU32( buf, uint32_t(v));}
+
+void putF32( std::vector<char> &buf, float f)
+{
+    uint32_t v;
+    std::memcpy( &v, &f, sizeof(float));
+    putU32( buf, v);
+}   // end putF32
+
+
+class Reader
+{
+public:
+    explicit Reader( std::istream &is) : _is(is), _ok(true) {}
+
+    bool ok() const { return _ok && _is.good();}
+
+    uint32_t u32()
+    {
+        unsigned char b[4] = {0,0,0,0};
+        if ( !_is.read( reinterpret_cast<char*>(b), 4))
+            _ok = false;
+        return uint32_t(b[0]) | (uint32_t(b[1]) << 8) | (uint32_t(b[2]) << 16) | (uint32_t(b[3]) << 24);
+    }   // end u32
+
+    int32_t i32() { return int32_t( u32());}
+
+    float f32()
+    {
+        const uint32_t v = u32();
+        float f;
+        std::memcpy( &f, &v, sizeof(float));
+        return f;
+    }   // end f32
+
+    // Returns false if the stream is seekable and has fewer than n bytes remaining.
+    // Counts read from the header are checked with this before allocating for them.
+    bool has( uint64_t n)
+    {
+        const std::streampos pos = _is.tellg();
+        if ( pos < 0 || !_is.seekg( 0, std::ios::end))
+        {
+            _is.clear();
+            return true;    // Not seekable so can't tell
+        }   // end if
+        const std::streampos end = _is.tellg();
+        _is.seekg( pos);
+        if ( end < pos || uint64_t(end - pos) < n)
+            _ok = false;
+        return _ok;
+    }   // end has
+
+    bool bytes( std::vector<uchar> &buf, size_t n)
+    {
+        if ( !has(n))
+            return false;
+        buf.resize(n);
+        if ( n > 0 && !_is.read( reinterpret_cast<char*>(buf.data()), std::streamsize(n)))
+            _ok = false;
+        return _ok;
+    }   // end bytes
+
+private:
+    std::istream &_is;
+    bool _ok;
+};  // end class
+
+}   // end namespace
+
+
+bool FaceTools::FileIO::writeBinaryMesh( const Mesh &m, std::ostream &os)
+{
+    Mesh::Ptr rmesh;
+    const Mesh *mesh = &m;
+    if ( !m.hasSequentialIds())
+    {
+        rmesh = m.repackedCopy();
+        mesh = rmesh.get();
+    }   // end if
+
+    const int NV = int(mesh->numVtxs());
+    const int NF = int(mesh->numFaces());
+
+    std::vector<char> buf;
+    buf.reserve( 16 + size_t(NV)*12 + size_t(NF)*12);
+    buf.insert( buf.end(), MAGIC, MAGIC+4);
+    putU32( buf, BINARY_MESH_VERSION);
+
+    // Vertices are stored transformed (as is done when saving as OBJ).
+    putU32( buf, uint32_t(NV));
+    for ( int i = 0; i < NV; ++i)
+    {
+        const Vec3f &v = mesh->vtx(i);
+        putF32( buf, v[0]);
+        putF32( buf, v[1]);
+        putF32( buf, v[2]);
+    }   // end for
+
+    putU32( buf, uint32_t(NF));
+    for ( int i = 0; i < NF; ++i)
+    {
+        const int *fvidxs = mesh->fvidxs(i);
+        putI32( buf, fvidxs[0]);
+        putI32( buf, fvidxs[1]);
+        putI32( buf, fvidxs[2]);
+    }   // end for
+
+    putU32( buf, uint32_t(mesh->numMats()));
+    for ( int mid : mesh->materialIds())
+    {
+        std::vector<uchar> tbuf;
+        const cv::Mat &tx = mesh->texture(mid);
+        if ( !tx.empty() && !cv::imencode( ".png", tx, tbuf))
+            return false;
+        putU32( buf, uint32_t(tbuf.size()));
+        buf.insert( buf.end(), tbuf.begin(), tbuf.end());
+
+        const IntSet &mfids = mesh->materialFaceIds(mid);
+        putU32( buf, uint32_t(mfids.size()));
+        for ( int fid : mfids)
+        {
+            putI32( buf, fid);
+            for ( int i = 0; i < 3; ++i)
+            {
+                const Vec2f &uv = mesh->faceUV( fid, i);
+                putF32( buf, uv[0]);
+                putF32( buf, uv[1]);
+            }   // end for
+        }   // end for
+    }   // end for
+
+    os.write( buf.data(), std::streamsize(buf.size()));
+    return bool(os);
+}   // end writeBinaryMesh
+
+
+bool FaceTools::FileIO::writeBinaryMesh( const Mesh &mesh, const QString &fpath)
+{
+    std::ofstream ofs( fpath.toLocal8Bit().toStdString(), std::ios::binary);
+    return ofs.is_open() && writeBinaryMesh( mesh, ofs);
+}   // end writeBinaryMesh
+
+
+Mesh::Ptr FaceTools::FileIO::readBinaryMesh( std::istream &is)
+{
+    static const std::string WSTR = "[WARNING] FaceTools::FileIO::readBinaryMesh: ";
+    char magic[4];
+    if ( !is.read( magic, 4) || std::memcmp( magic, MAGIC, 4) != 0)
+    {
+        std::cerr << WSTR << "Not a binary mesh!" << std::endl;
+        return nullptr;
+    }   // end if
+
+    Reader rdr( is);
+    const uint32_t version = rdr.u32();
+    if ( !rdr.ok() || version > BINARY_MESH_VERSION)
+    {
+        std::cerr << WSTR << "Unsupported binary mesh version " << version << std::endl;
+        return nullptr;
+    }   // end if
+
+    Mesh::Ptr mesh = Mesh::create();
+
+    // Vertex IDs are mapped in case the mesh merges coincident vertices.
+    const uint32_t NV = rdr.u32();
+    if ( !rdr.ok() || !rdr.has( uint64_t(NV) * 12))
+    {
+        std::cerr << WSTR << "Vertex count exceeds the data available!" << std::endl;
+        return nullptr;
+    }   // end if
+    std::vector<int> vmap( NV);
+    for ( uint32_t i = 0; i < NV && rdr.ok(); ++i)
+    {
+        const float x = rdr.f32();
+        const float y = rdr.f32();
+        const float z = rdr.f32();
+        vmap[i] = mesh->addVertex( Vec3f( x, y, z));
+    }   // end for
+
+    if ( !rdr.ok())
+    {
+        std::cerr << WSTR << "Truncated binary mesh!" << std::endl;
+        return nullptr;
+    }   // end if
+
+    const uint32_t NF = rdr.u32();
+    if ( !rdr.ok() || !rdr.has( uint64_t(NF) * 12))
+    {
+        std::cerr << WSTR << "Face count exceeds the data available!" << std::endl;
+        return nullptr;
+    }   // end if
+    std::vector<int> fmap( NF, -1);
+    for ( uint32_t i = 0; i < NF && rdr.ok(); ++i)
+    {
+        const int32_t v0 = rdr.i32();
+        const int32_t v1 = rdr.i32();
+        const int32_t v2 = rdr.i32();
+        if ( v0 < 0 || v1 < 0 || v2 < 0 || uint32_t(v0) >= NV || uint32_t(v1) >= NV || uint32_t(v2) >= NV)
+        {
+            std::cerr << WSTR << "Face has invalid vertex index!" << std::endl;
+            return nullptr;
+        }   // end if
+        fmap[i] = mesh->addFace( vmap[v0], vmap[v1], vmap[v2]);
+    }   // end for
+
+    const uint32_t NM = rdr.u32();
+    for ( uint32_t m = 0; m < NM && rdr.ok(); ++m)
+    {
+        std::vector<uchar> tbuf;
+        if ( !rdr.bytes( tbuf, rdr.u32()))
+            break;
+        const cv::Mat tx = tbuf.empty() ? cv::Mat() : cv::imdecode( tbuf, cv::IMREAD_UNCHANGED);
+        const int mid = mesh->addMaterial( tx);
+
+        const uint32_t NMF = rdr.u32();
+        for ( uint32_t j = 0; j < NMF && rdr.ok(); ++j)
+        {
+            const int32_t fid = rdr.i32();
+            Vec2f uvs[3];
+            for ( int i = 0; i < 3; ++i)
+            {
+                uvs[i][0] = rdr.f32();
+                uvs[i][1] = rdr.f32();
+            }   // end for
+            if ( fid >= 0 && uint32_t(fid) < NF && fmap[fid] >= 0)
+                mesh->setOrderedFaceUVs( mid, fmap[fid], uvs[0], uvs[1], uvs[2]);
+        }   // end for
+    }   // end for
+
+    if ( !rdr.ok())
+    {
+        std::cerr << WSTR << "Truncated binary mesh!" << std::endl;
+        return nullptr;
+    }   // end if
+
+    return mesh;
+}   // end readBinaryMesh
+
+
+Mesh::Ptr FaceTools::FileIO::readBinaryMesh( const QString &fpath)
+{
+    std::ifstream ifs( fpath.toLocal8Bit().toStdString(), std::ios::binary);
+    if ( !ifs.is_open())
+        return nullptr;
+    return readBinaryMesh( ifs);
+}   // end readBinaryMesh
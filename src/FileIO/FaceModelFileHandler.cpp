@@ -33,6 +33,24 @@ FM* FaceModelFileHandler::read( const QString&)
 }   // end read
 
 
+FM* FaceModelFileHandler::readReentrant( const QString &fname, QString &err)
+{
+    QMutexLocker lock( &_rmutex);
+    FM *fm = read( fname);
+    err = fm ? "" : error();
+    return fm;
+}   // end readReentrant
+
+
+bool FaceModelFileHandler::writeReentrant( const FM *fm, const QString &fname, QString &err)
+{
+    QMutexLocker lock( &_rmutex);
+    const bool ok = write( fm, fname);
+    err = ok ? "" : error();
+    return ok;
+}   // end writeReentrant
+
+
 bool FaceModelFileHandler::write( const FM*, const QString&)
 {
     if ( canWrite())
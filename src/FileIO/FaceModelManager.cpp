@@ -17,14 +17,19 @@
 
 #include <FileIO/FaceModelManager.h>
 #include <MiscFunctions.h>
+#include <SurfaceDataArchive.h>
+#include <Trace.h>
 #include <FaceModel.h>
 #include <FaceTools.h>
 #include <QFileInfo>
 #include <QDebug>
+#include <algorithm>
+#include <mutex>
 #include <cassert>
 using FaceTools::FileIO::FaceModelManager;
 using FaceTools::FileIO::FaceModelFileHandler;
 using FaceTools::FileIO::FaceModelFileHandlerMap;
+using FaceTools::SurfaceDataArchive;
 using FaceTools::FMS;
 using FaceTools::FM;
 
@@ -34,15 +39,23 @@ FaceModelFileHandlerMap FaceModelManager::_fhmap;
 FMS FaceModelManager::_models;
 std::unordered_map<FM*, QString> FaceModelManager::_mdata;
 std::unordered_map<QString, FM*> FaceModelManager::_mfiles;    // Lookup models by current filepath
-QString FaceModelManager::_err;
+QSet<QString> FaceModelManager::_loading;
+QReadWriteLock FaceModelManager::_lock;
+
+namespace {
+thread_local QString _err;  // Error from the last read or write in the calling thread
+}   // end namespace
 
 
 void FaceModelManager::add( FaceModelFileHandler* fii) { if ( fii) _fhmap.add(fii);}
 
 
+QString FaceModelManager::error() { return _err;}
+
+
 bool FaceModelManager::hasPreferredFileFormat( const FM &fm)
 {
-    return isPreferredFileFormat( _mdata.at(const_cast<FM*>(&fm)));
+    return isPreferredFileFormat( filepath(fm));
 }   // end hasPreferredFileFormat
 
 
@@ -66,8 +79,11 @@ void FaceModelManager::_setModelFilepath( const FM &cfm, const QString& fname)
 bool FaceModelManager::write( const FM &cfm, QString &fpath)
 {
     FM* fm = const_cast<FM*>(&cfm);
+    _lock.lockForRead();
     assert( _models.count(fm) > 0);
     QString savefilepath = _mdata.at(fm);
+    _lock.unlock();
+
     QString delfilepath;    // Will not be empty if replacing filename
     if ( fpath.isEmpty())
         fpath = savefilepath;
@@ -77,18 +93,22 @@ bool FaceModelManager::write( const FM &cfm, QString &fpath)
         savefilepath = fpath;
     }   // end else
 
+    const Trace::Scope trace( "file", "FaceModelManager::write", savefilepath);
     _err = "";  // Reset the error
     FaceModelFileHandler* fileio = _fhmap.writeInterface( savefilepath);
+    QString err;
     if ( !fileio)
         _err = "File \"" + savefilepath + "\" is not an allowed file type!";
     else if ( !fileio->canWrite())
         _err = "Cannot write to " + fileio->getFileDescription() + " files!";
-    else if ( !fileio->write( fm, savefilepath))
-        _err = fileio->error();
+    else if ( !fileio->writeReentrant( fm, savefilepath, err))   // Handlers are shared across threads
+        _err = err;
     else    // Successful write
     {
+        _lock.lockForWrite();
         _mfiles.erase(delfilepath);
         _setModelFilepath( *fm, savefilepath);
+        _lock.unlock();
         fm->setModelSaved( fileio->canWriteTextures() || !fm->hasTexture());
         fm->setMetaSaved( isPreferredFileFormat(savefilepath) || !fm->hasMetaData());
     }   // end else
@@ -131,19 +151,36 @@ bool FaceModelManager::canSaveTextures( const QString &fpath)
 bool FaceModelManager::isOpen( const QString& fn)
 {
     const QFileInfo finfo(fn);
+    QReadLocker lock( &_lock);
     return _mfiles.count( finfo.filePath()) > 0;
 }   // end isOpen
 
 
 FM* FaceModelManager::read( const QString& fn)
+{
+    QString err;
+    FM *fm = _read( fn, err);
+    _err = err;
+    return fm;
+}   // end read
+
+
+FM* FaceModelManager::_read( const QString& fn, QString &err)
 {
     const QFileInfo finfo(fn);
     const QString fname = finfo.filePath();
+    const Trace::Scope trace( "file", "FaceModelManager::read", fname);
 
-    _err = "";
-    if ( _mfiles.count(fname) > 0)
+    err = "";
+    _lock.lockForWrite();
+    const bool isopen = _mfiles.count(fname) > 0 || _loading.contains(fname);
+    if ( !isopen)
+        _loading.insert(fname); // Reserve so no other thread tries to read the same file
+    _lock.unlock();
+
+    if ( isopen)
     {
-        _err = "File \"" + fname + "\" already open!";
+        err = "File \"" + fname + "\" already open!";
         std::cerr << "Model already loaded!" << std::endl;
         return nullptr;
     }   // end if
@@ -151,32 +188,67 @@ FM* FaceModelManager::read( const QString& fn)
     FaceModelFileHandler* fileio = nullptr;
     FM* fm = nullptr;
     if ( !finfo.exists())
-        _err = "File \"" + fname + "\" does not exist!";
+        err = "File \"" + fname + "\" does not exist!";
     else if ( (fileio = _fhmap.readInterface(fname)) == nullptr)
-        _err = "File \"" + fname + "\" is not an allowed file type!";
+        err = "File \"" + fname + "\" is not an allowed file type!";
     else if ( !fileio->canRead())
-        _err = "Cannot read from " + fileio->getFileDescription() + " files!";
-    else if ( (fm = fileio->read( fname)) == nullptr)
-        _err = fileio->error();
-    else
+        err = "Cannot read from " + fileio->getFileDescription() + " files!";
+    else if ( (fm = fileio->readReentrant( fname, err)) != nullptr)
     {
-        _setModelFilepath( *fm, fname);
         fm->setModelSaved( true);
         fm->setMetaSaved( true);
-    }   // end else
+    }   // end else if
+
+    _lock.lockForWrite();
+    _loading.remove(fname);
+    if ( fm)
+        _setModelFilepath( *fm, fname);
+    _lock.unlock();
 
     return fm;
+}   // end _read
+
+
+std::vector<FaceModelManager::ReadResult> FaceModelManager::read( const QStringList &fnames,
+                                                                  const ReadCallback &cb, size_t maxThreads)
+{
+    const size_t N = size_t(fnames.size());
+    std::vector<ReadResult> results(N);
+    if ( maxThreads == 0)
+        maxThreads = N;
+
+    // Files are read in (at most maxThreads) interleaved batches on the shared pool.
+    const size_t nbatches = std::min( N, maxThreads);
+    size_t ndone = 0;
+    std::mutex cbmutex;
+    FaceTools::parallelFor( nbatches, [&]( size_t b)
+    {
+        for ( size_t i = b; i < N; i += nbatches)
+        {
+            ReadResult &res = results[i];
+            res.filepath = fnames.at(int(i));
+            res.model = _read( res.filepath, res.error);
+            std::lock_guard<std::mutex> lock( cbmutex);
+            ndone++;
+            if ( cb)
+                cb( res, ndone, N);
+        }   // end for
+    }, 1);
+
+    return results;
 }   // end read
 
 
-const QString& FaceModelManager::filepath( const FM &fm)
+QString FaceModelManager::filepath( const FM &fm)
 {
+    QReadLocker lock( &_lock);
     return _mdata.at(const_cast<FM*>(&fm));
 }   // end filepath
 
 
 FM* FaceModelManager::model( const QString& fname)
 {
+    QReadLocker lock( &_lock);
     FM* fm = nullptr;
     if ( _mfiles.count(fname) > 0)
         fm = _mfiles.at(fname);
@@ -187,10 +259,13 @@ FM* FaceModelManager::model( const QString& fname)
 void FaceModelManager::close( const FM &cfm)
 {
     FM* fm = const_cast<FM*>(&cfm);
+    _lock.lockForWrite();
     assert(_models.count(fm) > 0);
     _mfiles.erase(_mdata.at(fm));
     _models.erase(fm);
     _mdata.erase(fm);
+    _lock.unlock();
+    SurfaceDataArchive::purge(fm);  // Any surface data read in but never claimed
     delete fm;
 }   // end close
 
@@ -198,6 +273,7 @@ void FaceModelManager::close( const FM &cfm)
 FM *FaceModelManager::other( const FM &ifm)
 {
     assert( _loadLimit == 2);
+    QReadLocker lock( &_lock);
     FM *ofm = nullptr;
     if ( _models.size() == 2)
     {
@@ -213,6 +289,20 @@ FM *FaceModelManager::other( const FM &ifm)
 }   // end other
 
 
+size_t FaceModelManager::numOpen()
+{
+    QReadLocker lock( &_lock);
+    return _mdata.size();
+}   // end numOpen
+
+
+FMS FaceModelManager::opened()
+{
+    QReadLocker lock( &_lock);
+    return _models;
+}   // end opened
+
+
 void FaceModelManager::printFormats( std::ostream& os)
 {
     os << _fhmap << std::endl;
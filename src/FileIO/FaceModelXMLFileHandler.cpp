@@ -16,9 +16,13 @@
  ************************************************************************/
 
 #include <FileIO/FaceModelXMLFileHandler.h>
+#include <FileIO/BinaryMesh.h>
 #include <Action/ActionUpdateThumbnail.h>
 #include <Metric/PhenotypeManager.h>
 #include <MaskRegistration.h>
+#include <FaceModelCurvatureStore.h>
+#include <FaceModelSymmetryStore.h>
+#include <SurfaceDataArchive.h>
 #include <FaceTools.h>
 #include <FaceModel.h>
 #include <Ethnicities.h>
@@ -26,6 +30,8 @@
 #include <r3dio/IOHelpers.h>
 #include <QTemporaryDir>
 #include <quazip5/JlCompress.h>
+#include <quazip5/quazip.h>
+#include <quazip5/quazipfile.h>
 #include <boost/property_tree/xml_parser.hpp>
 #include <boost/algorithm/string.hpp>
 #include <sstream>
@@ -34,6 +40,9 @@ using FaceTools::FileIO::FaceModelXMLFileHandler;
 using FaceTools::Metric::PhenotypeManager;
 using FaceTools::Metric::Phenotype;
 using FaceTools::FM;
+using FMCS = FaceTools::FaceModelCurvatureStore;
+using FMSS = FaceTools::FaceModelSymmetryStore;
+using FaceTools::SurfaceDataArchive;
 
 
 void FaceTools::FileIO::exportMetaData( const FM &fm, bool withExtras, PTree& tnode)
@@ -106,21 +115,91 @@ PTree& exportXMLHeader( PTree& tree)
     records.put( "<xmlattr>.count", 1);
     return records;
 }   // end exportXMLHeader
+
+
+static const QString CURVATURE_FNAME = "curvature.bin";
+static const QString SYMMETRY_FNAME = "symmetry.bin";
+
+// Return a copy of the given 3-vector array with each vector rotated by R.
+vtkSmartPointer<vtkFloatArray> rotatedVectors( vtkFloatArray *arr, const FaceTools::Mat3f &R)
+{
+    vtkSmartPointer<vtkFloatArray> rarr = vtkSmartPointer<vtkFloatArray>::New();
+    rarr->DeepCopy( arr);
+    const vtkIdType n = rarr->GetNumberOfTuples();
+    float *vals = rarr->GetPointer(0);
+    for ( vtkIdType i = 0; i < n; ++i)
+    {
+        Eigen::Map<FaceTools::Vec3f> v( &vals[3*i]);
+        v = R * v;
+    }   // end for
+    return rarr;
+}   // end rotatedVectors
+
+
+bool writeSurfaceData( const SurfaceDataArchive::Arrays &arrs, size_t hash, const QString &fpath)
+{
+    std::ofstream ofs( fpath.toLocal8Bit().toStdString(), std::ios::binary);
+    return ofs.is_open() && SurfaceDataArchive::write( arrs, hash, ofs);
+}   // end writeSurfaceData
+
+
+// Write out the model's surface maps (where available) tagged with the hash of the content they were
+// calculated over. Failing to write these isn't an error since they can always be recalculated.
+void writeSurfaceData( const FM &fm, const QTemporaryDir &tdir)
+{
+    // Per-vertex arrays can't be matched to meshes that are repacked on writing.
+    if ( !fm.mesh().hasSequentialIds())
+        return;
+
+    if ( FMCS::RPtr cmap = FMCS::rvals( fm))
+    {
+        // Normals are stored in the transformed frame since the transform isn't saved.
+        const FaceTools::Mat3f R = fm.transformMatrix().block<3,3>(0,0);
+        const SurfaceDataArchive::Arrays arrs = { cmap->meanArray(), cmap->absArray(), cmap->d2Array(),
+                                                  rotatedVectors( cmap->normals(), R)};
+        if ( !writeSurfaceData( arrs, FMCS::contentHash( fm), tdir.filePath( CURVATURE_FNAME)))
+            std::cerr << "[WARN] FaceTools::FileIO::writeSurfaceData: Unable to write curvature data!" << std::endl;
+    }   // end if
+
+    if ( fm.hasMask() && FMSS::isMapped( &fm))
+    {
+        if ( const auto symm = FMSS::vals( &fm))
+        {
+            const SurfaceDataArchive::Arrays arrs = { symm->xArray(), symm->yArray(), symm->zArray(), symm->allArray()};
+            if ( !writeSurfaceData( arrs, FMSS::contentHash( &fm), tdir.filePath( SYMMETRY_FNAME)))
+                std::cerr << "[WARN] FaceTools::FileIO::writeSurfaceData: Unable to write symmetry data!" << std::endl;
+        }   // end if
+    }   // end if
+}   // end writeSurfaceData
+
 }   // end namespace
 
 
 // public
 bool FaceModelXMLFileHandler::write( const FM* fm, const QString& fname)
+{
+    return _write( fm, fname, _err);
+}   // end write
+
+
+bool FaceModelXMLFileHandler::writeReentrant( const FM* fm, const QString& fname, QString &err)
+{
+    return _write( fm, fname, err);
+}   // end writeReentrant
+
+
+// private static
+bool FaceModelXMLFileHandler::_write( const FM* fm, const QString& fname, QString &err)
 {
     assert(fm);
-    _err = "";
+    err = "";
 
     try
     {
         QTemporaryDir tdir( QDir::tempPath() + "/" + QFileInfo( fname).baseName());
         if ( !tdir.isValid())
         {
-            _err = "Unable to create temporary directory for writing to!";
+            err = "Unable to create temporary directory for writing to!";
             return false;
         }   // end if
 
@@ -128,28 +207,33 @@ bool FaceModelXMLFileHandler::write( const FM* fm, const QString& fname)
         ofs.open( tdir.filePath( "meta.xml").toLocal8Bit().toStdString());
         if ( !ofs.is_open())
         {
-            _err = "Cannot open output file stream for writing metadata!";
+            err = "Cannot open output file stream for writing metadata!";
             return false;
         }   // end if
 
         // Export metadata
+        const QString meshfname = "mesh." + BINARY_MESH_EXTENSION;
         PTree tree;
         PTree& rnode = exportXMLHeader( tree);
         exportMetaData( *fm, false/*no extra data*/, rnode);
+        rnode.get_child("FaceModel").put( "MeshFilename", meshfname.toStdString());
         boost::property_tree::write_xml( ofs, tree);
         ofs.close();
 
-        // Write out the model geometry itself into .obj format.
-        if ( !r3dio::saveAsOBJ( fm->mesh(), tdir.filePath( "mesh.obj").toLocal8Bit().toStdString(), false/*as jpeg*/))
+        // Write out the model geometry itself in compact binary format.
+        if ( !writeBinaryMesh( fm->mesh(), tdir.filePath( meshfname)))
         {
-            _err = "Failed to write mesh!";
+            err = "Failed to write mesh!";
             return false;
         }   // end if
 
+        if ( SurfaceDataArchive::isEnabled())
+            writeSurfaceData( *fm, tdir);
+
         // Write out the mask if set
         if ( fm->hasMask() && !r3dio::saveAsPLY( fm->mask(), tdir.filePath( "mask.ply").toLocal8Bit().toStdString()))
         {
-            _err = "Failed to write mask!";
+            err = "Failed to write mask!";
             return false;
         }   // end if
 
@@ -157,27 +241,27 @@ bool FaceModelXMLFileHandler::write( const FM* fm, const QString& fname)
         const cv::Mat img = Action::ActionUpdateThumbnail::thumbnail( fm);
         if ( !img.empty() && !cv::imwrite( tdir.filePath("thumb.jpg").toLocal8Bit().toStdString(), img))
         {
-            _err = "Unable to write thumbnail!";
+            err = "Unable to write thumbnail!";
             return false;
         }   // end if
 
         // Finally, zip up the contents of the directory into fname.
         if ( !JlCompress::compressDir( fname, tdir.path(), true/*recursively pack subdirs*/))
         {
-            _err = "Unable to compress saved data into archive format!";
+            err = "Unable to compress saved data into archive format!";
             return false;
         }   // end if
     }   // end try
     catch ( const std::exception& e)
     {
         std::cerr << "[EXCEPTION] FaceTools::FileIO::FaceModelXMLFileHandler::write: Failed to write to " << fname.toStdString() << std::endl;
-        if ( _err.isEmpty())
-            _err = e.what();
-        std::cerr << _err.toStdString() << std::endl;
+        if ( err.isEmpty())
+            err = e.what();
+        std::cerr << err.toStdString() << std::endl;
     }   // end catch
 
-    return _err.isEmpty();
-}   // end write
+    return err.isEmpty();
+}   // end _write
 
 
 namespace {
@@ -200,7 +284,9 @@ QString getStringRecord( const PTree &n, const QString &camelCaseLabel)
 
 void importModelRecord( FM &fm, const PTree& rnode, QString &meshfname, QString &maskfname)
 {
-    meshfname = getStringRecord( rnode, "ObjFilename");
+    meshfname = getStringRecord( rnode, "MeshFilename");
+    if ( meshfname.isEmpty())   // Older versions always stored the mesh as OBJ
+        meshfname = getStringRecord( rnode, "ObjFilename");
     if ( meshfname.isEmpty())
         meshfname = "mesh.obj";
 
@@ -404,33 +490,14 @@ bool FaceTools::FileIO::importMetaData( FM &fm, const PTree& tree, double &fvers
 }   // end importMetaData
 
 
-QString FaceTools::FileIO::readMeta( const QString &fname, QTemporaryDir &tdir, PTree &tree)
+namespace {
+
+QString parseMeta( std::istream &is, PTree &tree)
 {
     QString err;
-
     try
     {
-        if ( !tdir.isValid())
-            return "Unable to open temporary directory for reading from!";
-
-        QStringList fnames = JlCompress::extractDir( fname, tdir.path());
-        if ( fnames.isEmpty())
-            return "Unable to extract files from archive!";
-
-        QStringList xmlList = QDir( tdir.path()).entryList( {"*.xml"});
-        QString xmlfile;
-        if ( xmlList.size() == 1)
-            xmlfile = tdir.filePath( xmlList.first());
-
-        if ( xmlfile.isEmpty() || !QFileInfo(xmlfile).isFile())
-            return "Cannot find metadata in archive!";
-
-        std::ifstream ifs;
-        ifs.open( xmlfile.toLocal8Bit().toStdString());
-        if ( !ifs.is_open())
-            return "Cannot open metadata file for reading!";
-
-        boost::property_tree::read_xml( ifs, tree);
+        boost::property_tree::read_xml( is, tree);
     }   // end try
     catch ( const boost::property_tree::ptree_bad_path&)
     {
@@ -444,7 +511,127 @@ QString FaceTools::FileIO::readMeta( const QString &fname, QTemporaryDir &tdir,
     {
         err = "Unable to read in stream data!";
     }   // end catch
+    return err;
+}   // end parseMeta
+
+
+// Read the named entry from the open archive into bytes returning true on success.
+bool readEntry( QuaZip &zip, const QString &ename, QByteArray &bytes)
+{
+    if ( !zip.setCurrentFile( ename))
+        return false;
+    QuaZipFile zfile( &zip);
+    if ( !zfile.open( QIODevice::ReadOnly))
+        return false;
+    bytes = zfile.readAll();
+    zfile.close();
+    return zfile.getZipError() == UNZ_OK;
+}   // end readEntry
+
 
+bool readSurfaceData( const QString &fpath, SurfaceDataArchive::Arrays &arrs, size_t &hash, size_t nvtxs)
+{
+    std::ifstream ifs( fpath.toLocal8Bit().toStdString(), std::ios::binary);
+    return ifs.is_open() && SurfaceDataArchive::read( ifs, arrs, hash, nvtxs);
+}   // end readSurfaceData
+
+
+// Hold any surface maps in the extracted archive calculated over the same content as the
+// model now has so that the stores can use them rather than recalculating.
+void readSurfaceData( const FM &fm, const QTemporaryDir &tdir)
+{
+    SurfaceDataArchive::Arrays arrs;
+    size_t hash;
+    const size_t nvtxs = size_t( fm.mesh().numVtxs());
+
+    const QString cpath = tdir.filePath( CURVATURE_FNAME);
+    if ( QFileInfo( cpath).isFile() && readSurfaceData( cpath, arrs, hash, nvtxs) && arrs.size() == 4
+            && hash != 0 && hash == FMCS::contentHash( fm))
+    {
+        const FaceTools::Mat3f R = fm.inverseTransformMatrix().block<3,3>(0,0);
+        arrs[3] = rotatedVectors( arrs[3], R);
+        SurfaceDataArchive::set( &fm, FMCS::name(), hash, arrs);
+    }   // end if
+
+    const QString spath = tdir.filePath( SYMMETRY_FNAME);
+    if ( fm.hasMask() && QFileInfo( spath).isFile() && readSurfaceData( spath, arrs, hash, nvtxs)
+            && hash != 0 && hash == FMSS::contentHash( &fm))
+        SurfaceDataArchive::set( &fm, FMSS::name(), hash, arrs);
+}   // end readSurfaceData
+
+}   // end namespace
+
+
+QString FaceTools::FileIO::readMeta( const QString &fname, QTemporaryDir &tdir, PTree &tree)
+{
+    if ( !tdir.isValid())
+        return "Unable to open temporary directory for reading from!";
+
+    QStringList fnames = JlCompress::extractDir( fname, tdir.path());
+    if ( fnames.isEmpty())
+        return "Unable to extract files from archive!";
+
+    QStringList xmlList = QDir( tdir.path()).entryList( {"*.xml"});
+    QString xmlfile;
+    if ( xmlList.size() == 1)
+        xmlfile = tdir.filePath( xmlList.first());
+
+    if ( xmlfile.isEmpty() || !QFileInfo(xmlfile).isFile())
+        return "Cannot find metadata in archive!";
+
+    std::ifstream ifs;
+    ifs.open( xmlfile.toLocal8Bit().toStdString());
+    if ( !ifs.is_open())
+        return "Cannot open metadata file for reading!";
+
+    return parseMeta( ifs, tree);
+}   // end readMeta
+
+
+QString FaceTools::FileIO::readMeta( const QString &fname, PTree &tree, cv::Mat *thumb)
+{
+    QuaZip zip( fname);
+    if ( !zip.open( QuaZip::mdUnzip))
+        return "Unable to open archive!";
+
+    // Only top level entries are considered (as when extracting).
+    QString xmlentry;
+    bool hasThumb = false;
+    for ( const QString &ename : zip.getFileNameList())
+    {
+        if ( ename.contains('/'))
+            continue;
+        if ( ename.endsWith( ".xml", Qt::CaseInsensitive))
+        {
+            if ( !xmlentry.isEmpty())
+                return "Cannot find metadata in archive!";  // More than one
+            xmlentry = ename;
+        }   // end if
+        else if ( ename == "thumb.jpg")
+            hasThumb = true;
+    }   // end for
+
+    if ( xmlentry.isEmpty())
+        return "Cannot find metadata in archive!";
+
+    QByteArray bytes;
+    if ( !readEntry( zip, xmlentry, bytes))
+        return "Cannot read metadata from archive!";
+
+    std::istringstream iss( bytes.toStdString());
+    const QString err = parseMeta( iss, tree);
+
+    if ( err.isEmpty() && thumb)
+    {
+        *thumb = cv::Mat();
+        if ( hasThumb && readEntry( zip, "thumb.jpg", bytes))
+        {
+            const std::vector<uchar> buf( bytes.begin(), bytes.end());
+            *thumb = cv::imdecode( buf, cv::IMREAD_COLOR);
+        }   // end if
+    }   // end if
+
+    zip.close();
     return err;
 }   // end readMeta
 
@@ -455,7 +642,11 @@ QString FaceTools::FileIO::loadData( FM &fm, const QTemporaryDir &tdir, const QS
     try
     {
         // Raw model - no post process undertaken!
-        r3d::Mesh::Ptr mesh = r3dio::loadMesh( tdir.filePath( meshfname).toLocal8Bit().toStdString());
+        r3d::Mesh::Ptr mesh;
+        if ( QFileInfo( meshfname).suffix().toLower() == BINARY_MESH_EXTENSION)
+            mesh = readBinaryMesh( tdir.filePath( meshfname));
+        else
+            mesh = r3dio::loadMesh( tdir.filePath( meshfname).toLocal8Bit().toStdString());
         if ( mesh)
         {
             fm.update( mesh, true, false/*don't resettle landmarks (or update paths) just read in*/);
@@ -498,38 +689,53 @@ QString FaceTools::FileIO::loadData( FM &fm, const QTemporaryDir &tdir, const QS
 
 FM* FaceModelXMLFileHandler::read( const QString& fname)
 {
-    _err = "";
+    return _read( fname, _err, _fversion);
+}   // end read
+
+
+FM* FaceModelXMLFileHandler::readReentrant( const QString& fname, QString &err)
+{
+    double fversion;
+    return _read( fname, err, fversion);
+}   // end readReentrant
+
+
+FM* FaceModelXMLFileHandler::_read( const QString& fname, QString &err, double &fversion)
+{
+    err = "";
 
     QTemporaryDir tdir;
     if ( !tdir.isValid())
     {
-        _err = "Unable to create temporary directory for file extraction!";
+        err = "Unable to create temporary directory for file extraction!";
         return nullptr;
     }   // end if
 
     FM *fm = new FM;
     PTree tree;
-    _err = readMeta( fname, tdir, tree);
-    if ( _err.isEmpty())
+    err = readMeta( fname, tdir, tree);
+    if ( err.isEmpty())
     {
-        _fversion = 0.0;
+        fversion = 0.0;
         QString meshfname, maskfname;
-        if ( !importMetaData( *fm, tree, _fversion, meshfname, maskfname))
-            _err = QObject::tr("No FaceModel objects recorded in file!");
+        if ( !importMetaData( *fm, tree, fversion, meshfname, maskfname))
+            err = QObject::tr("No FaceModel objects recorded in file!");
         else
         {
-            if ( _fversion > XML_VERSION.toDouble())
-                _err = QObject::tr("File version is more recent than this library allows!");
+            if ( fversion > XML_VERSION.toDouble())
+                err = QObject::tr("File version is more recent than this library allows!");
             else
-                _err = loadData( *fm, tdir, meshfname, maskfname);
+                err = loadData( *fm, tdir, meshfname, maskfname);
+            if ( err.isEmpty())
+                readSurfaceData( *fm, tdir);
         }   // end else
     }   // end if
 
-    if ( !_err.isEmpty())
+    if ( !err.isEmpty())
     {
         delete fm;
         fm = nullptr;
     }   // end if
 
     return fm;
-}   // end read
+}   // end _read
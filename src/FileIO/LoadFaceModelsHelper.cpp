@@ -104,13 +104,13 @@ size_t LoadFaceModelsHelper::loadModels()
 {
     _loaded.clear();
     _failnames.clear();
-    for ( const QString& fname : _filenames)
+    const std::vector<FMM::ReadResult> results = FMM::read( _filenames);   // Blocks (reads concurrently)
+    for ( const FMM::ReadResult &res : results)
     {
-        FM* fm = FMM::read( fname);   // Blocks
-        if ( fm)
-            _loaded.insert( fm);
+        if ( res.model)
+            _loaded.insert( res.model);
         else
-            _failnames[FMM::error()] << fname;
+            _failnames[res.error] << res.filepath;
     }   // end for
     _filenames.clear();
     return _loaded.size();
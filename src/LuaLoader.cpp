@@ -0,0 +1,192 @@
+/************************************************************************
+ * Copyright (C) 2021 SIS Research Ltd & Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#include <LuaLoader.h>
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QFile>
+#include <QDir>
+#include <iostream>
+using FaceTools::LuaLoader;
+
+bool LuaLoader::_useCache(true);
+
+
+namespace {
+
+// Bytecode is only valid for the Lua version and the build's type sizes and byte order that
+// produced it (and Lua doesn't check it on loading) so these are hashed along with the source.
+QByteArray cacheKey( const QByteArray &code)
+{
+    QCryptographicHash hash( QCryptographicHash::Md5);
+    hash.addData( code);
+    hash.addData( QString("%1:%2:%3:%4:%5:%6").arg( LUA_VERSION_NUM).arg( sizeof(int)).arg( sizeof(size_t))
+                        .arg( sizeof(lua_Integer)).arg( sizeof(lua_Number)).arg( Q_BYTE_ORDER).toLatin1());
+    return hash.result().toHex();
+}   // end cacheKey
+
+
+const QFile::Permissions OTHERS_WRITE = QFile::WriteGroup | QFile::WriteOther;
+
+
+// The cache directory is private to the user running the application. Returns an empty
+// string if it can't be created as such or if its permissions have since been widened.
+QString cacheDir()
+{
+    const QString cdir = QDir( QStandardPaths::writableLocation( QStandardPaths::AppLocalDataLocation)).filePath( "luac");
+    if ( !QFileInfo::exists( cdir) && (!QDir().mkpath( cdir)
+            || !QFile::setPermissions( cdir, QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner)))
+        return "";
+    const QFileInfo dinfo( cdir);
+    if ( !dinfo.isDir() || (dinfo.permissions() & OTHERS_WRITE) || !dinfo.isWritable())
+        return "";
+    return cdir;
+}   // end cacheDir
+
+
+QString cacheFilePath( const QByteArray &code)
+{
+    const QString cdir = cacheDir();
+    return cdir.isEmpty() ? "" : QDir( cdir).filePath( QString("%1.luac").arg( QString( cacheKey( code))));
+}   // end cacheFilePath
+
+
+// Only chunks in files writable by no one else are trusted.
+bool isTrusted( const QString &cpath)
+{
+    const QFileInfo finfo( cpath);
+    return finfo.isFile() && (finfo.permissions() & OTHERS_WRITE) == 0 && finfo.ownerId() == QFileInfo( QFileInfo( cpath).path()).ownerId();
+}   // end isTrusted
+
+
+int appendChunk( lua_State*, const void *p, size_t sz, void *ud)
+{
+    static_cast<QByteArray*>(ud)->append( static_cast<const char*>(p), int(sz));
+    return 0;
+}   // end appendChunk
+
+
+void writeCache( lua_State *L, const QString &cpath)
+{
+    QByteArray bc;
+    if ( lua_dump( L, appendChunk, &bc, 0) != 0)
+        return;
+    // Written to a temporary then renamed since other threads may be reading the same chunk.
+    QSaveFile file( cpath);
+    if ( !file.open( QIODevice::WriteOnly) || !file.setPermissions( QFile::ReadOwner | QFile::WriteOwner)
+            || file.write( bc) != bc.size() || !file.commit())
+        std::cerr << "[WARNING] FaceTools::LuaLoader: Unable to write compiled chunk to " << cpath.toStdString() << std::endl;
+}   // end writeCache
+
+
+// On success, leaves the loaded chunk on top of the stack.
+void loadChunk( lua_State *L, const QByteArray &code, const QString &chunkName, bool useCache)
+{
+    const std::string cname = "@" + chunkName.toStdString();
+    const QString cpath = useCache ? cacheFilePath( code) : "";
+    if ( !cpath.isEmpty() && isTrusted( cpath))
+    {
+        QFile file( cpath);
+        if ( file.open( QIODevice::ReadOnly))
+        {
+            const QByteArray bc = file.readAll();
+            if ( luaL_loadbufferx( L, bc.constData(), size_t(bc.size()), cname.c_str(), "b") == LUA_OK)
+                return;
+            lua_pop( L, 1); // Corrupt or from a different version of Lua so recompile
+        }   // end if
+    }   // end if
+
+    if ( luaL_loadbufferx( L, code.constData(), size_t(code.size()), cname.c_str(), "t") != LUA_OK)
+    {
+        const std::string err = lua_tostring( L, -1);
+        lua_pop( L, 1);
+        throw sol::error( err);
+    }   // end if
+
+    if ( !cpath.isEmpty())
+        writeCache( L, cpath);
+}   // end loadChunk
+
+
+// Run the chunk on top of the stack (popping it) with the given environment (if not null) as its globals.
+void runChunk( lua_State *L, const sol::environment *env)
+{
+    if ( env)
+    {
+        env->push();
+        if ( !lua_setupvalue( L, -2, 1))    // A main chunk's first upvalue is always _ENV
+            lua_pop( L, 1);
+    }   // end if
+    if ( lua_pcall( L, 0, 0, 0) != LUA_OK)
+    {
+        const std::string err = lua_tostring( L, -1);
+        lua_pop( L, 1);
+        throw sol::error( err);
+    }   // end if
+}   // end runChunk
+
+}   // end namespace
+
+
+sol::state &LuaLoader::sharedState()
+{
+    thread_local sol::state lua;
+    thread_local bool init = false;
+    if ( !init)
+    {
+        lua.open_libraries( sol::lib::base);
+        init = true;
+    }   // end if
+    return lua;
+}   // end sharedState
+
+
+void LuaLoader::scriptFile( sol::state &lua, const QString &fpath)
+{
+    QFile file( fpath);
+    if ( !file.open( QIODevice::ReadOnly))
+        throw sol::error( QString("cannot open %1").arg(fpath).toStdString());
+    script( lua, file.readAll(), fpath);
+}   // end scriptFile
+
+
+sol::environment LuaLoader::scriptFileIsolated( sol::state &lua, const QString &fpath)
+{
+    QFile file( fpath);
+    if ( !file.open( QIODevice::ReadOnly))
+        throw sol::error( QString("cannot open %1").arg(fpath).toStdString());
+    sol::environment env( lua, sol::create, lua.globals());
+    lua_State *L = lua.lua_state();
+    loadChunk( L, file.readAll(), fpath, _useCache);
+    runChunk( L, &env);
+    return env;
+}   // end scriptFileIsolated
+
+
+void LuaLoader::script( sol::state &lua, const QByteArray &code, const QString &chunkName)
+{
+    lua_State *L = lua.lua_state();
+    loadChunk( L, code, chunkName, _useCache);
+    runChunk( L, nullptr);
+}   // end script
+
+
+void LuaLoader::setCacheEnabled( bool v) { _useCache = v;}
+
+bool LuaLoader::isCacheEnabled() { return _useCache;}
@@ -16,24 +16,36 @@
  ************************************************************************/
 
 #include <MaskRegistration.h>
+#include <TaskState.h>
+#include <Trace.h>
 #include <FileIO/FaceModelXMLFileHandler.h>
 #include <FileIO/FaceModelManager.h>
 #include <FaceModelViewer.h>
 #include <FaceModel.h>
 #include <rNonRigid.h>
+#include <QCryptographicHash>
+#include <QStandardPaths>
 #include <QFileInfo>
+#include <QDateTime>
 #include <QThread>
+#include <QFile>
+#include <QDir>
 #include <r3d/ProcrustesSuperimposition.h>
 #include <r3d/Bounds.h>
 #include <boost/filesystem/path.hpp>
 #include <boost/functional/hash.hpp>
+#include <unordered_set>
+#include <cstring>
 //#include <thread>
 using FaceTools::MaskRegistration;
 using FaceTools::FaceSide;
+using FaceTools::TaskState;
+using FaceTools::Trace;
 using FMM = FaceTools::FileIO::FaceModelManager;
 
 
 MaskRegistration::MaskData MaskRegistration::s_mask;
+const float MaskRegistration::COARSE_VOXEL_SCALE(0.025f);
 QReadWriteLock MaskRegistration::s_lock;
 
 
@@ -103,6 +115,272 @@ void binPointIndices( MaskRegistration::MaskData &md, float y, int vidx, int ovi
     }   // end if
 }   // end binPointIndices
 
+
+// The mask data derived from the mask file are cached to avoid recalculating them each time the
+// mask is loaded. The cache is a flat native endian binary file keyed by the mask file's
+// absolute path and is only used if the recorded mask file size and modification time match.
+static const char CACHE_MAGIC[4] = {'F','T','M','C'};
+static const quint32 CACHE_VERSION = 1;
+
+using LmkMap = std::unordered_map<int, std::pair<int, r3d::Vec3f> >;
+using IntSet = FaceTools::IntSet;
+
+
+QString cacheFilePath( const QString &abspath)
+{
+    const QString cdir = QStandardPaths::writableLocation( QStandardPaths::CacheLocation);
+    const QByteArray key = QCryptographicHash::hash( abspath.toUtf8(), QCryptographicHash::Md5).toHex();
+    return QDir( cdir).filePath( QString("mask_%1.cache").arg( QString( key)));
+}   // end cacheFilePath
+
+
+class CacheWriter
+{
+public:
+    template <typename T> void put( const T &v) { _buf.append( reinterpret_cast<const char*>(&v), sizeof(T));}
+
+    void put( const std::vector<int> &v)
+    {
+        put( quint64( v.size()));
+        _buf.append( reinterpret_cast<const char*>( v.data()), int( v.size() * sizeof(int)));
+    }   // end put
+
+    void put( const IntSet &s) { put( std::vector<int>( s.begin(), s.end()));}
+
+    void put( const LmkMap &lmks)
+    {
+        put( quint64( lmks.size()));
+        for ( const auto &p : lmks)
+        {
+            put( qint32( p.first));
+            put( qint32( p.second.first));
+            put( p.second.second[0]);
+            put( p.second.second[1]);
+            put( p.second.second[2]);
+        }   // end for
+    }   // end put
+
+    const QByteArray &bytes() const { return _buf;}
+
+private:
+    QByteArray _buf;
+};  // end class
+
+
+class CacheReader
+{
+public:
+    CacheReader( const uchar *p, qint64 n) : _p(p), _end(p + n) {}
+
+    template <typename T> bool get( T &v)
+    {
+        if ( _p + sizeof(T) > _end)
+            return false;
+        memcpy( &v, _p, sizeof(T));
+        _p += sizeof(T);
+        return true;
+    }   // end get
+
+    bool get( std::vector<int> &v)
+    {
+        quint64 n;
+        if ( !get(n) || n > quint64(_end - _p) / sizeof(int))
+            return false;
+        v.resize( n);
+        memcpy( v.data(), _p, n * sizeof(int));
+        _p += n * sizeof(int);
+        return true;
+    }   // end get
+
+    bool get( IntSet &s)
+    {
+        std::vector<int> v;
+        if ( !get(v))
+            return false;
+        s = IntSet( v.begin(), v.end());
+        return true;
+    }   // end get
+
+    bool get( LmkMap &lmks)
+    {
+        quint64 n;
+        if ( !get(n))
+            return false;
+        lmks.clear();
+        for ( quint64 i = 0; i < n; ++i)
+        {
+            qint32 lmid, fid;
+            float x, y, z;
+            if ( !get(lmid) || !get(fid) || !get(x) || !get(y) || !get(z))
+                return false;
+            lmks[lmid] = std::pair<int, r3d::Vec3f>( fid, r3d::Vec3f( x, y, z));
+        }   // end for
+        return true;
+    }   // end get
+
+private:
+    const uchar *_p;
+    const uchar *_end;
+};  // end class
+
+
+void writeCache( const QString &abspath, const MaskRegistration::MaskData &md)
+{
+    const QFileInfo finfo( abspath);
+    CacheWriter cw;
+    cw.put( CACHE_MAGIC);
+    cw.put( CACHE_VERSION);
+    cw.put( qint64( finfo.size()));
+    cw.put( qint64( finfo.lastModified().toMSecsSinceEpoch()));
+    cw.put( quint64( md.oppVtxs.size()));
+    cw.put( quint64( md.hash));
+    cw.put( md.lmksL);
+    cw.put( md.lmksM);
+    cw.put( md.lmksR);
+    cw.put( md.oppVtxs);
+    cw.put( md.medialVtxs);
+    cw.put( md.q0);
+    cw.put( md.q1);
+    cw.put( md.q2);
+    cw.put( md.q3);
+    cw.put( md.centre[0]);
+    cw.put( md.centre[1]);
+    cw.put( md.centre[2]);
+    cw.put( md.radius);
+
+    const QString cpath = cacheFilePath( abspath);
+    QDir().mkpath( QFileInfo( cpath).absolutePath());
+    QFile file( cpath);
+    if ( !file.open( QIODevice::WriteOnly) || file.write( cw.bytes()) != cw.bytes().size())
+        std::cerr << "[WARNING] FaceTools::MaskRegistration: Unable to write mask cache to " << cpath.toStdString() << std::endl;
+}   // end writeCache
+
+
+// Read cached mask data into md returning true iff the cache exists, is valid for
+// the given mask file, and was created for a mask having the given number of vertices.
+bool readCache( const QString &abspath, size_t nvtxs, MaskRegistration::MaskData &md)
+{
+    QFile file( cacheFilePath( abspath));
+    if ( !file.open( QIODevice::ReadOnly))
+        return false;
+    const qint64 fsize = file.size();
+    const uchar *bytes = file.map( 0, fsize);
+    if ( !bytes)
+        return false;
+
+    const QFileInfo finfo( abspath);
+    CacheReader cr( bytes, fsize);
+    char magic[4];
+    quint32 version;
+    qint64 msize, mtime;
+    quint64 nv, hash;
+    bool ok = cr.get( magic) && memcmp( magic, CACHE_MAGIC, 4) == 0
+           && cr.get( version) && version == CACHE_VERSION
+           && cr.get( msize) && msize == finfo.size()
+           && cr.get( mtime) && mtime == finfo.lastModified().toMSecsSinceEpoch()
+           && cr.get( nv) && nv == quint64( nvtxs)
+           && cr.get( hash);
+
+    MaskRegistration::MaskData cmd;
+    ok = ok && cr.get( cmd.lmksL) && cr.get( cmd.lmksM) && cr.get( cmd.lmksR)
+            && cr.get( cmd.oppVtxs) && cmd.oppVtxs.size() == nvtxs
+            && cr.get( cmd.medialVtxs)
+            && cr.get( cmd.q0) && cr.get( cmd.q1) && cr.get( cmd.q2) && cr.get( cmd.q3)
+            && cr.get( cmd.centre[0]) && cr.get( cmd.centre[1]) && cr.get( cmd.centre[2])
+            && cr.get( cmd.radius);
+    file.unmap( const_cast<uchar*>( bytes));
+
+    if ( ok)
+    {
+        md.hash = size_t( hash);
+        md.lmksL.swap( cmd.lmksL);
+        md.lmksM.swap( cmd.lmksM);
+        md.lmksR.swap( cmd.lmksR);
+        md.oppVtxs.swap( cmd.oppVtxs);
+        md.medialVtxs.swap( cmd.medialVtxs);
+        md.q0.swap( cmd.q0);
+        md.q1.swap( cmd.q1);
+        md.q2.swap( cmd.q2);
+        md.q3.swap( cmd.q3);
+        md.centre = cmd.centre;
+        md.radius = cmd.radius;
+    }   // end if
+    return ok;
+}   // end readCache
+
+
+// Calculate the mask data derived from the given mask model.
+void calcMaskData( const FaceTools::FM *fm, MaskRegistration::MaskData &md)
+{
+    using namespace FaceTools;
+    md.hash = createHash( fm->mesh());
+
+    // Note that there's an opportunity here to have a mask store several different
+    // sets of landmarks (perhaps derived from different assessors of whatever).
+    const Landmark::LandmarkSet& lmset = fm->currentLandmarks();
+    md.lmksL.clear();
+    md.lmksM.clear();
+    md.lmksR.clear();
+    setBarycentricLandmarkPositions( md.lmksL, lmset.lateral( LEFT), fm->kdtree());
+    setBarycentricLandmarkPositions( md.lmksM, lmset.lateral( MID), fm->kdtree());
+    setBarycentricLandmarkPositions( md.lmksR, lmset.lateral( RIGHT), fm->kdtree());
+
+    // Set the laterally opposite vertex IDs:
+    md.oppVtxs.assign( fm->mesh().numVtxs(), -1);
+    md.medialVtxs.clear();
+    md.q0.clear();
+    md.q1.clear();
+    md.q2.clear();
+    md.q3.clear();
+    for ( int vidx : fm->mesh().vtxIds())
+    {
+        if ( md.oppVtxs[vidx] >= 0)
+            continue;
+
+        // Reflect the vertex through the medial plane and find the closest opposite vertex.
+        // It is assumed that the medial plane lies at X=0 and that the mesh is upright and laterally symmetric.
+        const Vec3f &p = fm->mesh().vtx(vidx);
+        const int ovidx = fm->kdtree().find( Vec3f( -p[0], p[1], p[2]));
+        md.oppVtxs[ovidx] = vidx;
+        md.oppVtxs[vidx] = ovidx;
+        if ( ovidx == vidx)
+           md.medialVtxs.insert(vidx);
+        // Partitioning of the vertices into the four quadrants is not mutually exclusive.
+        if ( p[0] >= 0)
+            binPointIndices( md, p[1], vidx, ovidx);
+        if ( p[0] <= 0)
+            binPointIndices( md, p[1], ovidx, vidx);
+    }   // end for
+
+    // Get the centre and height from just the medial vertices
+    const r3d::Bounds bnds( fm->mesh(), Mat4f::Identity(), &md.medialVtxs);
+    md.centre = bnds.centre();
+    md.radius = bnds.diagonal() / 2;
+}   // end calcMaskData
+
+
+// Return the target subsampled to keep at most one point in each cubic voxel of the given size.
+rNonRigid::Mesh voxelSubsample( const rNonRigid::Mesh &m, float vsize)
+{
+    const long N = m.features.rows();
+    std::unordered_set<int64_t> cells;
+    std::vector<long> rows;
+    rows.reserve( N);
+    for ( long i = 0; i < N; ++i)
+    {
+        const int64_t ix = int64_t( floorf( m.features(i,0) / vsize)) & 0x1fffff;
+        const int64_t iy = int64_t( floorf( m.features(i,1) / vsize)) & 0x1fffff;
+        const int64_t iz = int64_t( floorf( m.features(i,2) / vsize)) & 0x1fffff;
+        if ( cells.insert( (ix << 42) | (iy << 21) | iz).second)
+            rows.push_back(i);
+    }   // end for
+
+    rNonRigid::Mesh sm( rows.size(), m.features.cols());
+    for ( size_t j = 0; j < rows.size(); ++j)
+        sm.features.row(j) = m.features.row(rows[j]);
+    return sm;
+}   // end voxelSubsample
+
 }   // end namespace
 
 
@@ -119,7 +397,7 @@ void MaskRegistration::unsetMask()
 
 
 
-bool MaskRegistration::setMask( const QString &mpath)
+bool MaskRegistration::setMask( const QString &mpath, bool async)
 {
     const QString abspath = QFileInfo( mpath).absoluteFilePath();
     if ( s_mask.path == abspath)
@@ -157,59 +435,13 @@ bool MaskRegistration::setMask( const QString &mpath)
     }   // end if
 
     //std::cout << "Loading anthropomorphic mask for surface registration..." << std::endl;
-    QThread *thread = QThread::create(
-        [abspath, meshfname, tdir, fm]()
-        {
-            s_lock.lockForWrite();  // Setting lock here since need to wait for file op to finish
-            QString unused;
-            const QString err = FileIO::loadData( *fm, *tdir, meshfname, unused);
-            if ( err.isEmpty())
-            {
-                s_mask.mask = fm;
-                s_mask.path = abspath;
-                s_mask.hash = createHash( fm->mesh());
-
-                // Note that there's an opportunity here to have a mask store several different
-                // sets of landmarks (perhaps derived from different assessors of whatever).
-                const Landmark::LandmarkSet& lmset = fm->currentLandmarks();
-                setBarycentricLandmarkPositions( s_mask.lmksL, lmset.lateral( LEFT), fm->kdtree());
-                setBarycentricLandmarkPositions( s_mask.lmksM, lmset.lateral( MID), fm->kdtree());
-                setBarycentricLandmarkPositions( s_mask.lmksR, lmset.lateral( RIGHT), fm->kdtree());
-
-                // Set the laterally opposite vertex IDs:
-                for ( int vidx : fm->mesh().vtxIds())
-                {
-                    if ( s_mask.oppVtxs.count(vidx) > 0)
-                        continue;
-
-                    // Reflect the vertex through the medial plane and find the closest opposite vertex.
-                    // It is assumed that the medial plane lies at X=0 and that the mesh is upright and laterally symmetric.
-                    const Vec3f &p = fm->mesh().vtx(vidx);
-                    const int ovidx = fm->kdtree().find( Vec3f( -p[0], p[1], p[2]));
-                    s_mask.oppVtxs[ovidx] = vidx;
-                    s_mask.oppVtxs[vidx] = ovidx;
-                    if ( ovidx == vidx)
-                       s_mask.medialVtxs.insert(vidx);
-                    // Partitioning of the vertices into the four quadrants is not mutually exclusive.
-                    if ( p[0] >= 0)
-                        binPointIndices( s_mask, p[1], vidx, ovidx);
-                    if ( p[0] <= 0)
-                        binPointIndices( s_mask, p[1], ovidx, vidx);
-                }   // end for
-
-                // Get the centre and height from just the medial vertices
-                const r3d::Bounds bnds( fm->mesh(), Mat4f::Identity(), &s_mask.medialVtxs);
-                s_mask.centre = bnds.centre();
-                s_mask.radius = bnds.diagonal() / 2;
-            }   // end if
-            else
-            {
-                std::cerr << "Failed to load mask data!" << std::endl;
-                delete fm;
-            }   // end else
-            delete tdir;
-            s_lock.unlock();
-        });
+    if ( !async)
+    {
+        _loadMask( abspath, meshfname, tdir, fm);
+        return maskLoaded();
+    }   // end if
+
+    QThread *thread = QThread::create( [abspath, meshfname, tdir, fm](){ _loadMask( abspath, meshfname, tdir, fm);});
     QObject::connect( thread, &QThread::finished, [thread](){ thread->deleteLater();});
     thread->start();
 
@@ -217,6 +449,32 @@ bool MaskRegistration::setMask( const QString &mpath)
 }   // end setMask
 
 
+void MaskRegistration::_loadMask( const QString &abspath, const QString &meshfname, QTemporaryDir *tdir, FM *fm)
+{
+    s_lock.lockForWrite();  // Setting lock here since need to wait for file op to finish
+    QString unused;
+    const QString err = FileIO::loadData( *fm, *tdir, meshfname, unused);
+    if ( err.isEmpty())
+    {
+        s_mask.mask = fm;
+        s_mask.path = abspath;
+        // Use the cached mask data if valid for this mask file, otherwise calculate and cache.
+        if ( !readCache( abspath, fm->mesh().numVtxs(), s_mask))
+        {
+            calcMaskData( fm, s_mask);
+            writeCache( abspath, s_mask);
+        }   // end if
+    }   // end if
+    else
+    {
+        std::cerr << "Failed to load mask data!" << std::endl;
+        delete fm;
+    }   // end else
+    delete tdir;
+    s_lock.unlock();
+}   // end _loadMask
+
+
 bool MaskRegistration::maskLoaded()
 {
     if ( !s_lock.tryLockForRead())
@@ -267,7 +525,7 @@ std::shared_ptr<const MaskRegistration::MaskData> MaskRegistration::maskData()
 }   // end maskData
 
 
-r3d::Mesh::Ptr MaskRegistration::registerMask( const r3d::KDTree &kdt)
+r3d::Mesh::Ptr MaskRegistration::registerMask( const r3d::KDTree &kdt, bool multires)
 {
     static const std::string ISTR = " FaceTools::Action::MaskRegistration::registerMask: ";
     assert( maskLoaded());
@@ -276,6 +534,13 @@ r3d::Mesh::Ptr MaskRegistration::registerMask( const r3d::KDTree &kdt)
         std::cerr << "[ERROR]" << ISTR << "Mask not loaded!" << std::endl;
         return nullptr;
     }   // end if
+    const Trace::Scope trace( "registration", "MaskRegistration::registerMask");
+
+    // The registration stages can't be interrupted part way through so cancellation
+    // is checked (and progress advanced) between them: rigid 10, coarse 60, fine 30.
+    TaskState *ts = TaskState::current();
+    if ( ts)
+        ts->addSteps(100);
 
     const MaskPtr mdata = maskData();
     rNonRigid::Mesh flt;
@@ -289,13 +554,22 @@ r3d::Mesh::Ptr MaskRegistration::registerMask( const r3d::KDTree &kdt)
     // Start with a 70% size mask since this empirically works better at fitting the
     // faces of babies and children without diminishing the ability to fit adult faces.
     Mat4f T = Mat4f::Identity() * 0.7f;
-    T = rNonRigid::RigidRegistration( 20, 3, 0.9f, true, 4.0f, true, 10, true)( flt, tgt, T);
+    // The rigid registration converges just as well against a coarse version of the target.
+    const float coarseVoxel = COARSE_VOXEL_SCALE * mdata->radius;
+    {
+        const Trace::Scope rtrace( "registration", "RigidRegistration");
+        T = rNonRigid::RigidRegistration( 20, 3, 0.9f, true, 4.0f, true, 10, true)( flt, multires ? voxelSubsample( tgt, coarseVoxel) : tgt, T);
+    }   // end trace scope
     const float minScale = std::min( T(0,0), std::min(T(1,1), T(2,2)));
     if ( minScale < 0.1f)
     {
         std::cerr << "[WARNING]" << ISTR << "Mask scaled to be too small!" << std::endl;
         return nullptr;
     }   // end if
+    if ( ts)
+        ts->advance(10);
+    if ( TaskState::cancelled())
+        return nullptr;
 
 #ifndef NDEBUG
     // Create mask to check that scaling didn't doesn't reduce the mask size too much.
@@ -316,7 +590,36 @@ r3d::Mesh::Ptr MaskRegistration::registerMask( const r3d::KDTree &kdt)
     for ( const std::pair<size_t, float> &p : vpts)
         tgt2.features.row(j++) = tgt.features.row(p.first);
 
-    rNonRigid::NonRigidRegistration( 80, 3, 0.9f, true, 10.0f, true, 10, 50, 1.6f, 80, 1, 80, 1)( flt, tgt2);
+    if ( multires)
+    {
+        // Coarse-to-fine: most iterations (with the heavier regularisation) are run against a coarse
+        // version of the target to get the mask into the right neighbourhood, before just a few
+        // iterations at full density refine it with the lighter end of the regularisation schedule.
+        {
+            const Trace::Scope rtrace( "registration", "NonRigidRegistration", "coarse");
+            rNonRigid::NonRigidRegistration( 60, 3, 0.9f, true, 10.0f, true, 10, 50, 1.6f, 80, 10, 80, 10)( flt, voxelSubsample( tgt2, coarseVoxel));
+        }   // end trace scope
+        if ( ts)
+            ts->advance(60);
+        if ( TaskState::cancelled())
+            return nullptr;
+        {
+            const Trace::Scope rtrace( "registration", "NonRigidRegistration", "fine");
+            rNonRigid::NonRigidRegistration( 20, 3, 0.9f, true, 10.0f, true, 10, 50, 1.6f, 10, 1, 10, 1)( flt, tgt2);
+        }   // end trace scope
+        if ( ts)
+            ts->advance(30);
+    }   // end if
+    else
+    {
+        const Trace::Scope rtrace( "registration", "NonRigidRegistration");
+        rNonRigid::NonRigidRegistration( 80, 3, 0.9f, true, 10.0f, true, 10, 50, 1.6f, 80, 1, 80, 1)( flt, tgt2);
+        if ( ts)
+            ts->advance(90);
+    }   // end else
+
+    if ( TaskState::cancelled())
+        return nullptr;
 
     r3d::Mesh::Ptr cmask = r3d::Mesh::fromVertices( flt.features.leftCols(3)); // Make the final mask
     if ( flt.features.rows() != (long)cmask->numVtxs())
@@ -332,6 +635,23 @@ r3d::Mesh::Ptr MaskRegistration::registerMask( const r3d::KDTree &kdt)
 }   // end registerMask
 
 
+float MaskRegistration::registrationError( const r3d::Mesh &mask, const r3d::KDTree &kdt)
+{
+    const r3d::SurfacePointFinder spfinder( kdt.mesh());
+    double sum = 0;
+    for ( int vidx : mask.vtxIds())
+    {
+        const Vec3f &v = mask.vtx(vidx);
+        int fid;
+        Vec3f fv;
+        int svidx = kdt.find(v);
+        spfinder.find( v, svidx, fid, fv);
+        sum += (fv - v).norm();
+    }   // end for
+    return mask.numVtxs() > 0 ? float( sum / mask.numVtxs()) : 0.0f;
+}   // end registrationError
+
+
 r3d::Mat4f MaskRegistration::calcMaskAlignment( const r3d::Mesh &mask)
 {
     const MaskPtr mdata = maskData();
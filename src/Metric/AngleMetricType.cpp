@@ -44,8 +44,7 @@ float AngleMetricType::update( size_t k, const FM *fm, const std::vector<Vec3f>&
     v0.normalize();
     v1.normalize();
 
-    _angleInfo[fm].resize( std::max( _angleInfo[fm].size(), k+1));
-    AngleMeasure &am = _angleInfo[fm][k];
+    AngleMeasure am;
     am.centre = c;
     am.normal = nrm;
 
@@ -65,6 +64,7 @@ float AngleMetricType::update( size_t k, const FM *fm, const std::vector<Vec3f>&
     am.point1 = r3d::transform( iT, am.point1);
     am.centre = r3d::transform( iT, am.centre);
     am.normal = iT.block<3,3>(0,0) * am.normal;
+    _angleInfo.set( fm, k, am);
 
     return am.degrees;
 }   // end update
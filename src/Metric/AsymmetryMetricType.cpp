@@ -55,8 +55,7 @@ float AsymmetryMetricType::update( size_t k, const FM *fm, const std::vector<Vec
     // the components of which give the four dimension values x,y,z and absolute magnitude. Note that the
     // x,y,z values are signed.
 
-    _asymmInfo[fm].resize( std::max( _asymmInfo[fm].size(), k+1));
-    AsymmetryMeasure &am = _asymmInfo[fm][k];
+    AsymmetryMeasure am;
 
     const Mat4f &iT = fm->inverseTransformMatrix();
     am.point0 = r3d::transform( iT, p);
@@ -72,5 +71,6 @@ float AsymmetryMetricType::update( size_t k, const FM *fm, const std::vector<Vec
     else
         v = am.delta.norm();
 
+    _asymmInfo.set( fm, k, am);
     return v;
 }   // end update
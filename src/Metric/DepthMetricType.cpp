@@ -58,11 +58,10 @@ float DepthMetricType::update( size_t k, const FM *fm, const std::vector<Vec3f>&
     }   // end else
 
     // Update cached values - note that all are stored untransformed for visualisation
-    _depthInfo[fm].resize( std::max( _depthInfo[fm].size(), k+1));
-    DepthMeasure &dm = _depthInfo[fm][k];
-    // Untransform for visualisation
+    DepthMeasure dm;
     const Mat4f iT = fm->inverseTransformMatrix();
     dm.p0 = r3d::transform( iT, mp);
     dm.p1 = r3d::transform( iT, sp);
+    _depthInfo.set( fm, k, dm);
     return (sp - mp).norm();
 }   // end update
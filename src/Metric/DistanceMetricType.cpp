@@ -43,8 +43,7 @@ void setProjectedPoints( DistMeasure &dm, const std::vector<Vec3f> &pts, const V
 float DistanceMetricType::update( size_t k, const FM *fm, const std::vector<Vec3f>& pts, Vec3f, Vec3f u, bool, bool inPlane)
 {
     assert( pts.size() == 2);
-    _distInfo[fm].resize( std::max( _distInfo[fm].size(), k+1));
-    DistMeasure &dm = _distInfo[fm][k];
+    DistMeasure dm;
 
     if ( inPlane)
         setProjectedPoints( dm, pts, u);
@@ -58,6 +57,7 @@ float DistanceMetricType::update( size_t k, const FM *fm, const std::vector<Vec3
     const Mat4f &iT = fm->inverseTransformMatrix();
     dm.point0 = r3d::transform( iT, dm.point0);
     dm.point1 = r3d::transform( iT, dm.point1);
+    _distInfo.set( fm, k, dm);
 
     return (dm.point0 - dm.point1).norm();
 }   // end update
@@ -18,9 +18,11 @@
 #include <Metric/GrowthData.h>
 #include <Metric/MetricManager.h>
 #include <Ethnicities.h>
+#include <LuaLoader.h>
 #include <FaceModel.h>
 #include <sol.hpp>
 #include <QSet>
+#include <cmath>
 using FaceTools::Metric::GrowthData;
 using FaceTools::Metric::MetricSet;
 using FaceTools::Metric::MetricValue;
@@ -241,6 +243,72 @@ bool GrowthData::isWithinAgeRange( float age) const
 }   // end isWithinAgeRange
 
 
+void GrowthData::prepareLookups() const { std::call_once( _lookupsOnce, [this](){ _makeLookups();});}
+
+
+void GrowthData::_makeLookups() const
+{
+    static const float SAMPLES_PER_YEAR = 12;
+    const size_t ndims = dims();
+    _lookups.resize( ndims);
+    for ( size_t d = 0; d < ndims; ++d)
+    {
+        rlib::RSD::CPtr rsd = _rsds[d];
+        if ( !rsd)
+            continue;
+
+        // Same domain as used for direct evaluation of the distribution by MetricValue
+        Lookup &lu = _lookups[d];
+        lu.t0 = float( rsd->tmin());
+        lu.t1 = std::max( lu.t0, float( int( rsd->tmax() + 0.5)));
+        const size_t n = std::max<size_t>( 2, size_t( std::ceil( (lu.t1 - lu.t0) * SAMPLES_PER_YEAR)) + 1);
+        lu.scale = float(n - 1) / std::max( lu.t1 - lu.t0, 1e-6f);
+        lu.means.resize(n);
+        lu.sds.resize(n);
+        for ( size_t k = 0; k < n; ++k)
+        {
+            const double t = lu.t0 + (lu.t1 - lu.t0) * double(k) / (n - 1);
+            lu.means[k] = float( rsd->mval(t));
+            lu.sds[k] = float( rsd->zval(t));   // Standard deviation at t
+        }   // end for
+    }   // end for
+}   // end _makeLookups
+
+
+bool GrowthData::_lookup( float age, size_t d, float &m, float &sd) const
+{
+    prepareLookups();
+    const Lookup &lu = _lookups.at(d);
+    if ( lu.means.empty())
+        return false;
+    const float x = (std::max( lu.t0, std::min( age, lu.t1)) - lu.t0) * lu.scale;
+    const size_t k = std::min( size_t(x), lu.means.size() - 2);
+    const float w = std::min( x - float(k), 1.0f);
+    m = (1.0f - w) * lu.means[k] + w * lu.means[k+1];
+    sd = (1.0f - w) * lu.sds[k] + w * lu.sds[k+1];
+    return true;
+}   // end _lookup
+
+
+float GrowthData::mean( float age, size_t d) const
+{
+    float m = 0;
+    float sd = 0;
+    _lookup( age, d, m, sd);
+    return m;
+}   // end mean
+
+
+float GrowthData::zscore( float age, float v, size_t d) const
+{
+    float m = 0;
+    float sd = 0;
+    if ( !_lookup( age, d, m, sd) || sd <= 0)
+        return 0;
+    return (v - m) / sd;
+}   // end zscore
+
+
 namespace {
 static const std::string WSTR = "[WARN] FaceTools::Metric::GrowthData::load: ";
 
@@ -289,13 +357,13 @@ void collectDistributionData( const sol::table &data, std::vector<rlib::RSD::Ptr
 
 bool GrowthData::load( const QString &fpath)
 {
-    sol::state lua;
-    lua.open_libraries( sol::lib::base);
+    sol::state &lua = LuaLoader::sharedState();
+    sol::environment env;
 
     bool loadedOkay = false;
     try
     {
-        lua.script_file( fpath.toStdString());
+        env = LuaLoader::scriptFileIsolated( lua, fpath);
         loadedOkay = true;
     }   // end try
     catch ( const sol::error& e)
@@ -308,7 +376,7 @@ bool GrowthData::load( const QString &fpath)
     if ( !loadedOkay)
         return false;
 
-    sol::table table = lua["stats"];
+    sol::table table = env["stats"];
     if ( !table.valid())
     {
         std::cerr << WSTR << "Lua file has no global member named stats!" << std::endl;
@@ -19,6 +19,9 @@
 #include <Ethnicities.h>
 #include <FaceModel.h>
 #include <QSet>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 using FaceTools::Metric::GrowthDataRanker;
 using GDS = FaceTools::Metric::GrowthDataSources;
 using GD = FaceTools::Metric::GrowthData;
@@ -37,9 +40,72 @@ void GrowthDataRanker::add( GD::Ptr gdptr)
     _stats[_gids] = gd;
     gdptr->setId( _gids++);
     _allptrs.insert(gdptr); // Just to keep alive
+
+    // Within age range over the intersection of the domains of all dimensions
+    double tmin = -DBL_MAX;
+    double tmax = DBL_MAX;
+    for ( size_t i = 0; i < gd->dims(); ++i)
+    {
+        if ( !gd->rsd(i))
+            continue;
+        tmin = std::max<double>( tmin, gd->rsd(i)->tmin());
+        tmax = std::min<double>( tmax, gd->rsd(i)->tmax());
+    }   // end for
+    for ( double t : {tmin, tmax})
+        if ( std::abs(t) < DBL_MAX)
+            _ageBounds.insert( std::lower_bound( _ageBounds.begin(), _ageBounds.end(), t), t);
+    _ageBounds.erase( std::unique( _ageBounds.begin(), _ageBounds.end()), _ageBounds.end());
+
+    _clearMemos();
 }   // end add
 
 
+void GrowthDataRanker::_clearMemos()
+{
+    QMutexLocker lock( &_mutex);
+    _ecompat.clear();
+    _bestMatches.clear();
+}   // end _clearMemos
+
+
+int GrowthDataRanker::_ageKey( float age) const
+{
+    if ( age <= 0.0f)   // Never within range
+        return -1;
+    // Even keys for the open intervals between bounds and odd keys for the bounds themselves
+    const auto it = std::lower_bound( _ageBounds.begin(), _ageBounds.end(), double(age));
+    const int i = int( it - _ageBounds.begin());
+    return 2*i + (it != _ageBounds.end() && *it == age ? 1 : 0);
+}   // end _ageKey
+
+
+const GD* GrowthDataRanker::bestMatch( const FM *fm) const
+{
+    if ( !fm)
+        return nullptr;
+    const int8_t sex = fm->sex();
+    const int meth = fm->maternalEthnicity();
+    const int peth = fm->paternalEthnicity();
+    const float age = fm->age();
+    const DemographicKey key( sex, meth, peth, _ageKey( age));
+
+    _mutex.lock();
+    const auto it = _bestMatches.find( key);
+    if ( it != _bestMatches.end())
+    {
+        const GD *gd = it->second;
+        _mutex.unlock();
+        return gd;
+    }   // end if
+    _mutex.unlock();
+
+    const GD *gd = bestMatch( _compatible( sex, meth, peth, age), sex, meth, peth, age);
+    QMutexLocker lock( &_mutex);
+    _bestMatches[key] = gd;
+    return gd;
+}   // end bestMatch
+
+
 std::unordered_set<int8_t> GrowthDataRanker::sexes() const
 {
     std::unordered_set<int8_t> sx;
@@ -178,6 +244,8 @@ const GD* GrowthDataRanker::bestMatch( const GDS &gds, int8_t sex, int meth, int
 #ifndef NDEBUG
     int mid = -1;
 #endif
+    const int midx = Ethnicities::index( meth);
+    const int pidx = Ethnicities::index( peth);
     for ( const GD *gd : gds)
     {
 #ifndef NDEBUG
@@ -185,8 +253,9 @@ const GD* GrowthDataRanker::bestMatch( const GDS &gds, int8_t sex, int meth, int
 #endif
 
         // Calculate the ethnicity match score
-        const int ms = Ethnicities::parentDegree( gd->ethnicity(), meth);
-        const int ps = Ethnicities::parentDegree( gd->ethnicity(), peth);
+        const int gidx = Ethnicities::index( gd->ethnicity());
+        const int ms = gd->ethnicity() == meth ? 0 : Ethnicities::parentDegreeAt( gidx, midx);
+        const int ps = gd->ethnicity() == peth ? 0 : Ethnicities::parentDegreeAt( gidx, pidx);
         int ethScore = std::max( ms, ps);   // Maximum to be most encompassing
         // Note here that either of ms or ps might be -1 (i.e., not be a child of the statistics)
         // but as long as one of them is, that's okay - the other will just be flagged as mismatching.
@@ -230,15 +299,16 @@ GDS GrowthDataRanker::compatible( const FM* fm) const
 {
     if ( !fm)
         return _all;
+    return _compatible( fm->sex(), fm->maternalEthnicity(), fm->paternalEthnicity(), fm->age());
+}   // end compatible
 
-    GDS gds;
 
-    const int8_t sex = fm->sex();
-    const int meth = fm->maternalEthnicity();
-    const int peth = fm->paternalEthnicity();
+GDS GrowthDataRanker::_compatible( int8_t sex, int meth, int peth, float age) const
+{
+    GDS gds;
 
     // Get data matching the mother's ethnicity
-    if ( fm->maternalEthnicity() != 0)
+    if ( meth != 0)
     {
         GDS m = _compatible( sex, meth);
         gds.insert( m.begin(), m.end());
@@ -271,7 +341,6 @@ GDS GrowthDataRanker::compatible( const FM* fm) const
     GDS ogds;
 
     // Finally, check by age - just want the stats with matching age range
-    const float age = fm->age();
     for ( const GD *gd : gds)
         if ( gd->isWithinAgeRange( age))
             ogds.insert(gd);
@@ -281,7 +350,7 @@ GDS GrowthDataRanker::compatible( const FM* fm) const
         ogds = gds;
 
     return ogds;
-}   // end compatible
+}   // end _compatible
 
 
 GDS GrowthDataRanker::compatible( int8_t sex, int ethn) const
@@ -324,10 +393,18 @@ const GD* GrowthDataRanker::stats( int gid) const
 
 GDS GrowthDataRanker::_compatible( int8_t sex, int ethn) const
 {
+    // Memoised since finding the ethnic group membership means comparing ethnicity codes
+    QMutexLocker lock( &_mutex);
+    std::unordered_map<int, GDS> &ecompat = _ecompat[sex];
+    const auto it = ecompat.find( ethn);
+    if ( it != ecompat.end())
+        return it->second;
+
     GDS mgds;
     _compatible( sex, ethn, mgds);
     if ( sex != UNKNOWN_SEX)
         _compatible( UNKNOWN_SEX, ethn, mgds);
+    ecompat[ethn] = mgds;
     return mgds;
 }   // end _compatible
 
@@ -342,8 +419,9 @@ void GrowthDataRanker::_compatible( int8_t sex, int ethn, GDS& mgds) const
         mgds = _sdata.at(sex);
     else
     {
+        const int eidx = FaceTools::Ethnicities::index( ethn);
         for ( const GD *gd : _sdata.at(sex))
-            if ( FaceTools::Ethnicities::belongs( gd->ethnicity(), ethn))
+            if ( gd->ethnicity() == ethn || FaceTools::Ethnicities::belongsAt( FaceTools::Ethnicities::index( gd->ethnicity()), eidx))
                 mgds.insert( gd);
     }   // end else
 }   // end _compatible
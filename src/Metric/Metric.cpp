@@ -19,6 +19,7 @@
 #include <Metric/MetricTypeRegistry.h>
 #include <Metric/StatsManager.h>
 #include <MiscFunctions.h>
+#include <LuaLoader.h>
 #include <FaceModel.h>
 #include <fstream>
 #include <boost/algorithm/string.hpp>
@@ -33,13 +34,13 @@ using SM = FaceTools::Metric::StatsManager;
 Metric::Ptr Metric::load( const QString &fpath)
 {
     static const std::string WSTR = "[WARN] FaceTools::Metric::Metric::load: ";
-    sol::state lua;
-    lua.open_libraries( sol::lib::base);
+    sol::state &lua = LuaLoader::sharedState();
+    sol::environment env;
 
     Metric::Ptr mc;
     try
     {
-        lua.script_file( fpath.toStdString());
+        env = LuaLoader::scriptFileIsolated( lua, fpath);
         mc = Ptr( new Metric, [](Metric* d){ delete d;});
     }   // end try
     catch ( const sol::error& e)
@@ -51,7 +52,7 @@ Metric::Ptr Metric::load( const QString &fpath)
     if ( !mc)
         return nullptr;
 
-    const sol::table table = lua["mc"];
+    const sol::table table = env["mc"];
     if ( !table.valid())
     {
         std::cerr << WSTR << "Lua file has no global member named mc!" << std::endl;
@@ -194,21 +195,37 @@ bool setIfMetricValueChanged( MetricSet &mset, const MetricValue &nv, int mid)
 
 
 bool Metric::_measure( FM *fm) const
+{
+    SideValues svals;
+    _calculate( fm, svals);
+    return _setValues( fm, svals);
+}   // end _measure
+
+
+void Metric::_calculate( const FM *fm, SideValues &svals) const
 {
     const bool inp = inPlane( fm);
-    const int mid = id();
-    bool cval = false;
-    FaceAssessment::Ptr ass = fm->currentAssessment();
-    assert( ass);
+    svals.clear();
     if ( isBilateral())
     {
-        cval |= setIfMetricValueChanged( ass->metrics(RIGHT), _measure( fm, true, inp), mid);
-        cval |= setIfMetricValueChanged( ass->metrics(LEFT), _measure( fm, false, inp), mid);
+        svals.push_back( std::make_pair( RIGHT, _measure( fm, true, inp)));
+        svals.push_back( std::make_pair( LEFT, _measure( fm, false, inp)));
     }   // end if
     else
-        cval |= setIfMetricValueChanged( ass->metrics(MID), _measure( fm, false, inp), mid);
+        svals.push_back( std::make_pair( MID, _measure( fm, false, inp)));
+}   // end _calculate
+
+
+bool Metric::_setValues( FM *fm, const SideValues &svals) const
+{
+    const int mid = id();
+    bool cval = false;
+    FaceAssessment::Ptr ass = fm->currentAssessment();
+    assert( ass);
+    for ( const auto &sv : svals)
+        cval |= setIfMetricValueChanged( ass->metrics(sv.first), sv.second, mid);
     return cval;
-}   // end _measure
+}   // end _setValues
 
 
 bool Metric::_canMeasure( const FM *fm) const
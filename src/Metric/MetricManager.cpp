@@ -16,6 +16,7 @@
  ************************************************************************/
 
 #include <Metric/MetricManager.h>
+#include <FaceTools.h>
 #include <QDir>
 #include <QFile>
 #include <QTextStream>
@@ -56,11 +57,14 @@ int MetricManager::load( const QString& dname)
         return -1;
     }   // end if
 
-    int nloaded = 0;
+    // Files are loaded concurrently then added in order so later files still overwrite earlier ones.
     const QStringList fnames = mdir.entryList( QDir::Files | QDir::Readable, QDir::Type | QDir::Name);
-    for ( const QString& fname : fnames)
+    std::vector<MC::Ptr> mcs( size_t( fnames.size()));
+    parallelFor( mcs.size(), [&]( size_t i){ mcs[i] = MC::load( mdir.absoluteFilePath( fnames.at(int(i))));}, 8);
+
+    int nloaded = 0;
+    for ( MC::Ptr mc : mcs)
     {
-        MC::Ptr mc = MC::load( mdir.absoluteFilePath(fname));
         if ( !mc)
             continue;
 
@@ -44,31 +44,15 @@ void MetricValue::setValues( const std::vector<float> &dvals, bool p)
 
 float MetricValue::zscore( float age, size_t i) const
 {
-    float zs = 0;
     SM::RPtr gd = SM::stats( _id, _fm);
-    if ( gd)
-    {
-        rlib::RSD::CPtr rsd = gd->rsd(i);
-        assert(rsd);
-        const double t = std::max<double>( rsd->tmin(), std::min<double>( age, int(rsd->tmax() + 0.5)));
-        zs = float(rsd->zscore( t, _values.at(i)));
-    }   // end if
-    return zs;
+    return gd ? gd->zscore( age, _values.at(i), i) : 0.0f;
 }   // end zscore
 
 
 float MetricValue::mean( float age, size_t i) const
 {
-    float mn = 0;
     SM::RPtr gd = SM::stats( _id, _fm);
-    if ( gd)
-    {
-        rlib::RSD::CPtr rsd = gd->rsd(i);
-        assert(rsd);
-        const double t = std::max<double>( rsd->tmin(), std::min<double>( age, int(rsd->tmax() + 0.5)));
-        mn = float(rsd->mval( t));
-    }   // end if
-    return mn;
+    return gd ? gd->mean( age, i) : 0.0f;
 }   // end mean
 
 
@@ -19,7 +19,10 @@
 #include <Metric/MetricManager.h>
 #include <Metric/StatsManager.h>
 #include <Ethnicities.h>
+#include <LuaLoader.h>
 #include <FaceModel.h>
+#include <QRegularExpression>
+#include <QFile>
 using FaceTools::Metric::Phenotype;
 using FaceTools::Metric::MetricSet;
 using FaceTools::Metric::MetricValue;
@@ -30,18 +33,78 @@ using FaceTools::FM;
 
 
 // private
-Phenotype::Phenotype() : _id(-1)
+Phenotype::Phenotype() : _id(-1) {}
+
+
+namespace {
+
+bool runScript( sol::state &lua, const QString &fpath)
+{
+    try
+    {
+        FaceTools::LuaLoader::scriptFile( lua, fpath);
+        return true;
+    }   // end try
+    catch ( const sol::error& e)
+    {
+        std::cerr << "[WARN] FaceTools::Metric::Phenotype::load: Unable to load and execute file '" << fpath.toStdString() << "'!" << std::endl;
+        std::cerr << "\t" << e.what() << std::endl;
+    }   // end catch
+    return false;
+}   // end runScript
+
+
+// Return the source of the given function as read from the file it was defined in.
+QString functionSource( const sol::function &fn, const QString &fpath)
 {
+    lua_State *L = fn.lua_state();
+    fn.push();
+    lua_Debug ar;
+    lua_getinfo( L, ">S", &ar); // Pops the function
+    if ( ar.linedefined <= 0 || ar.lastlinedefined < ar.linedefined)
+        return "";
+
+    QFile file( fpath);
+    if ( !file.open( QIODevice::ReadOnly | QIODevice::Text))
+        return "";
+    const QStringList lines = QString::fromUtf8( file.readAll()).split('\n');
+    if ( ar.lastlinedefined > lines.size())
+        return "";
+
+    QStringList flines = lines.mid( ar.linedefined - 1, ar.lastlinedefined - ar.linedefined + 1);
+    // The function is typically defined part way through its first line (e.g. "determine = function(...")
+    static const QRegularExpression FNRE( "\\b(local\\s+)?function\\b");
+    const int i = flines.first().indexOf( FNRE);
+    if ( i < 0)
+        return "";
+    flines.first() = flines.first().mid(i);
+    return flines.join('\n');
+}   // end functionSource
+
+}   // end namespace
+
+
+bool Phenotype::_loadLua( const QString &fpath)
+{
+    _lua.reset( new sol::state);
+    _lua->open_libraries( sol::lib::base);
+
     // Register MetricSet for Phenotype determination function:
-    _lua.new_usertype<MetricSet>( "MetricSet",
-                                  "metric", &MetricSet::metric);
+    _lua->new_usertype<MetricSet>( "MetricSet",
+                                   "metric", &MetricSet::metric);
 
-    _lua.new_usertype<MetricValue>( "MetricValue",
-                                    "ndims", &MetricValue::ndims,
-                                    "mean", &MetricValue::mean,
-                                    "value", &MetricValue::value,
-                                    "zscore", &MetricValue::zscore);
-}   // end ctor
+    _lua->new_usertype<MetricValue>( "MetricValue",
+                                     "ndims", &MetricValue::ndims,
+                                     "mean", &MetricValue::mean,
+                                     "value", &MetricValue::value,
+                                     "zscore", &MetricValue::zscore);
+
+    if ( !runScript( *_lua, fpath))
+        return false;
+    if ( sol::optional<sol::function> v = (*_lua)["hpo"]["determine"])
+        _determine = v.value();
+    return _determine.valid();
+}   // end _loadLua
 
 
 // public static
@@ -49,26 +112,25 @@ Phenotype::Ptr Phenotype::create() { return Ptr( new Phenotype, [](Phenotype *d)
 
 
 // public static
-Phenotype::Ptr Phenotype::load( const QString& fpath)
+Phenotype::Ptr Phenotype::load( const QString& fpath, bool compile)
 {
-    bool loadedOk = false;
-    Ptr hpo = create();
-    hpo->_lua.open_libraries( sol::lib::base);
+    // Read the definition using the calling thread's shared state. Only terms with
+    // determination functions that can't be compiled need a state of their own.
+    sol::state &lua = LuaLoader::sharedState();
+    sol::environment env;
     try
     {
-        hpo->_lua.script_file( fpath.toStdString());
-        loadedOk = true;
+        env = LuaLoader::scriptFileIsolated( lua, fpath);
     }   // end try
     catch ( const sol::error& e)
     {
         std::cerr << "[WARN] FaceTools::Metric::Phenotype::load: Unable to load and execute file '" << fpath.toStdString() << "'!" << std::endl;
         std::cerr << "\t" << e.what() << std::endl;
-    }   // end catch
-
-    if ( !loadedOk)
         return nullptr;
+    }   // end catch
 
-    auto table = hpo->_lua["hpo"];
+    Ptr hpo = create();
+    auto table = env["hpo"];
     if ( !table.valid())
     {
         std::cerr << "[WARN] FaceTools::Metric::Phenotype::load: Missing table 'hpo'!" << std::endl;
@@ -110,7 +172,20 @@ Phenotype::Ptr Phenotype::load( const QString& fpath)
     }   // end if
 
     if ( sol::optional<sol::function> v = table["determine"])
-        hpo->_determine = v.value();
+    {
+        QString err = "compilation disabled";
+        if ( compile)
+            hpo->_expr = PhenotypeExpression::compile( functionSource( v.value(), fpath), &err);
+        if ( !hpo->_expr)
+        {
+#ifndef NDEBUG
+            std::cerr << "[INFO] FaceTools::Metric::Phenotype::load: Using Lua for HP:" << hpo->_id
+                      << " (" << err.toStdString() << ")" << std::endl;
+#endif
+            if ( !hpo->_loadLua( fpath))
+                return nullptr;
+        }   // end if
+    }   // end if
 
     return hpo;
 }   // end load
@@ -142,21 +217,26 @@ bool Phenotype::_hasMeasurements( const FM &fm, int aid) const
 }   // end _hasMeasurements
 
 
-bool Phenotype::isPresent( const FM &fm, int aid) const
+bool Phenotype::isPresent( const FM &fm, int aid, const SM::LateralZScores *zs) const
 {
-    if ( !_determine.valid())
+    if ( !_expr && !_determine.valid())
         return false;
 
     if ( !_hasMeasurements(fm, aid))
         return false;
 
+    FaceAssessment::CPtr ass = aid < 0 ? fm.currentAssessment() : fm.assessment(aid);
+    const MetricSet& mlat = ass->cmetrics(MID);
+    const MetricSet& llat = ass->cmetrics(LEFT);
+    const MetricSet& rlat = ass->cmetrics(RIGHT);
+    if ( _expr)
+        return _expr->evaluate( fm.age(), mlat, llat, rlat, zs);
+
+    // A Lua state can only be used by one thread at a time
+    QMutexLocker lock( &_luaMutex);
     bool present = false;
     try
     {
-        FaceAssessment::CPtr ass = aid < 0 ? fm.currentAssessment() : fm.assessment(aid);
-        const MetricSet& mlat = ass->cmetrics(MID);
-        const MetricSet& llat = ass->cmetrics(LEFT);
-        const MetricSet& rlat = ass->cmetrics(RIGHT);
         sol::function_result result = _determine( fm.age(), mlat, llat, rlat);
         if ( result.valid())
             present = result;
@@ -0,0 +1,544 @@
+/************************************************************************
+ * Copyright (C) 2021 SIS Research Ltd & Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#include <Metric/PhenotypeExpression.h>
+#include <Metric/MetricManager.h>
+#include <stdexcept>
+#include <cassert>
+#include <cmath>
+using FaceTools::Metric::PhenotypeExpression;
+using FaceTools::Metric::MetricSet;
+using FaceTools::Metric::MetricValue;
+using FaceTools::Metric::StatsManager;
+using MM = FaceTools::Metric::MetricManager;
+using FaceTools::Metric::MC;
+
+
+namespace {
+
+enum class Op { NUM, AGE, ZSCORE, MEAN, VALUE, NDIMS, NEG, ADD, SUB, MUL, DIV,
+                LT, LE, GT, GE, EQ, NE, AND, OR, NOT, ABS, MIN, MAX, SQRT};
+
+enum class Type { NUM, BOOL};
+
+
+struct Token
+{
+    enum Kind { NAME, NUMBER, SYMBOL, END};
+    Kind kind;
+    QString text;
+    double num;
+};  // end struct
+
+
+using CompileError = std::runtime_error;
+
+void fail( const QString &msg) { throw CompileError( msg.toStdString());}
+
+
+std::vector<Token> tokenise( const QString &src)
+{
+    static const QStringList SYMBOLS = { "<=", ">=", "==", "~=", "<", ">", "+", "-", "*", "/",
+                                         "(", ")", ":", ",", ".", ";"};
+    std::vector<Token> toks;
+    const int n = src.size();
+    int i = 0;
+    while ( i < n)
+    {
+        const QChar c = src.at(i);
+        if ( c.isSpace())
+            i++;
+        else if ( src.midRef( i, 2) == "--")
+        {
+            if ( src.midRef( i, 3) == "--[")
+                fail( "block comments unsupported");
+            while ( i < n && src.at(i) != '\n')
+                i++;
+        }   // end else if
+        else if ( c.isLetter() || c == '_')
+        {
+            const int j = i;
+            while ( i < n && (src.at(i).isLetterOrNumber() || src.at(i) == '_'))
+                i++;
+            toks.push_back( {Token::NAME, src.mid( j, i-j), 0});
+        }   // end else if
+        else if ( c.isDigit() || (c == '.' && i+1 < n && src.at(i+1).isDigit()))
+        {
+            const int j = i;
+            while ( i < n && (src.at(i).isDigit() || src.at(i) == '.'))
+                i++;
+            if ( i < n && (src.at(i) == 'e' || src.at(i) == 'E'))
+            {
+                i++;
+                if ( i < n && (src.at(i) == '+' || src.at(i) == '-'))
+                    i++;
+                while ( i < n && src.at(i).isDigit())
+                    i++;
+            }   // end if
+            bool ok = false;
+            const QString txt = src.mid( j, i-j);
+            const double v = txt.toDouble( &ok);
+            if ( !ok)
+                fail( QString( "invalid number '%1'").arg(txt));
+            toks.push_back( {Token::NUMBER, txt, v});
+        }   // end else if
+        else
+        {
+            QString sym;
+            for ( const QString &s : SYMBOLS)
+                if ( src.midRef( i, s.size()) == s)
+                {
+                    sym = s;
+                    break;
+                }   // end if
+            if ( sym.isEmpty())  // Unsupported so rejected by the parser if reached
+                sym = c;
+            toks.push_back( {Token::SYMBOL, sym, 0});
+            i += sym.size();
+        }   // end else
+    }   // end while
+    toks.push_back( {Token::END, "", 0});
+    return toks;
+}   // end tokenise
+
+}   // end namespace
+
+
+struct PhenotypeExpression::Node
+{
+    Op op;
+    Type type;
+    int a;      // Operand indices (-1 if unused)
+    int b;
+    double num; // Literal value
+    int lat;    // Index of lateral set (0 medial, 1 left, 2 right)
+    int mid;    // Metric id
+};  // end struct
+
+
+class PhenotypeExpression::Parser
+{
+public:
+    Parser( const QString &src, PhenotypeExpression &pe) : _toks( tokenise( src)), _i(0), _pe(pe) {}
+
+    // Parse "[local] function [name]( age, mlat, llat, rlat) return <expr> [;] end"
+    void parseFunction()
+    {
+        if ( _isName( "local"))
+            _i++;
+        _expectName( "function");
+        if ( _peek().kind == Token::NAME)
+            _i++;
+        _expect( "(");
+        for ( int j = 0; j < 4; ++j)
+        {
+            if ( j > 0)
+                _expect( ",");
+            if ( _peek().kind != Token::NAME)
+                fail( "expected four parameters");
+            _params[j] = _next().text;
+        }   // end for
+        _expect( ")");
+        _expectName( "return");
+        _pe._root = _or();
+        if ( _pe._nodes[size_t(_pe._root)].type != Type::BOOL)
+            fail( "expression is not a boolean");
+        _accept( ";");
+        _expectName( "end");   // Anything following (e.g. table separators) is ignored
+    }   // end parseFunction
+
+private:
+    std::vector<Token> _toks;
+    size_t _i;
+    PhenotypeExpression &_pe;
+    QString _params[4];
+
+    const Token &_peek() const { return _toks[_i];}
+    const Token &_next() { const Token &t = _toks[_i]; if ( t.kind != Token::END) _i++; return t;}
+    bool _isName( const char *s) const { return _peek().kind == Token::NAME && _peek().text == s;}
+    bool _isSym( const char *s) const { return _peek().kind == Token::SYMBOL && _peek().text == s;}
+
+    bool _accept( const char *s)
+    {
+        if ( !_isSym(s))
+            return false;
+        _i++;
+        return true;
+    }   // end _accept
+
+    void _expect( const char *s)
+    {
+        if ( !_accept(s))
+            fail( QString( "expected '%1' but found '%2'").arg(s).arg(_peek().text));
+    }   // end _expect
+
+    void _expectName( const char *s)
+    {
+        if ( !_isName(s))
+            fail( QString( "expected '%1' but found '%2'").arg(s).arg(_peek().text));
+        _i++;
+    }   // end _expectName
+
+    Type _type( int n) const { return _pe._nodes[size_t(n)].type;}
+
+    int _add( Op op, Type type, int a=-1, int b=-1, double num=0, int lat=-1, int mid=-1)
+    {
+        _pe._nodes.push_back( {op, type, a, b, num, lat, mid});
+        return int(_pe._nodes.size()) - 1;
+    }   // end _add
+
+    int _numeric( int n)
+    {
+        if ( _type(n) != Type::NUM)
+            fail( "expected a numeric operand");
+        return n;
+    }   // end _numeric
+
+    int _or()
+    {
+        int n = _and();
+        while ( _isName( "or"))
+        {
+            _i++;
+            const int m = _and();
+            if ( _type(n) != _type(m))
+                fail( "operands of 'or' have different types");
+            n = _add( Op::OR, _type(n), n, m);
+        }   // end while
+        return n;
+    }   // end _or
+
+    int _and()
+    {
+        int n = _cmp();
+        while ( _isName( "and"))
+        {
+            _i++;
+            const int m = _cmp();
+            if ( _type(n) != _type(m))
+                fail( "operands of 'and' have different types");
+            n = _add( Op::AND, _type(n), n, m);
+        }   // end while
+        return n;
+    }   // end _and
+
+    int _cmp()
+    {
+        static const std::vector<std::pair<const char*, Op> > RELOPS = {
+            {"<", Op::LT}, {"<=", Op::LE}, {">", Op::GT}, {">=", Op::GE}, {"==", Op::EQ}, {"~=", Op::NE}};
+        int n = _arith();
+        bool found = true;
+        while ( found)
+        {
+            found = false;
+            for ( const auto &r : RELOPS)
+            {
+                if ( _isSym( r.first))
+                {
+                    _i++;
+                    const int m = _arith();
+                    if ( r.second == Op::EQ || r.second == Op::NE)
+                    {
+                        if ( _type(n) != _type(m))
+                            fail( "comparing values of different types");
+                    }   // end if
+                    else
+                    {
+                        _numeric(n);
+                        _numeric(m);
+                    }   // end else
+                    n = _add( r.second, Type::BOOL, n, m);
+                    found = true;
+                    break;
+                }   // end if
+            }   // end for
+        }   // end while
+        return n;
+    }   // end _cmp
+
+    int _arith()
+    {
+        int n = _term();
+        while ( _isSym("+") || _isSym("-"))
+        {
+            const Op op = _next().text == "+" ? Op::ADD : Op::SUB;
+            n = _add( op, Type::NUM, _numeric(n), _numeric(_term()));
+        }   // end while
+        return n;
+    }   // end _arith
+
+    int _term()
+    {
+        int n = _unary();
+        while ( _isSym("*") || _isSym("/"))
+        {
+            const Op op = _next().text == "*" ? Op::MUL : Op::DIV;
+            n = _add( op, Type::NUM, _numeric(n), _numeric(_unary()));
+        }   // end while
+        return n;
+    }   // end _term
+
+    int _unary()
+    {
+        if ( _isName( "not"))
+        {
+            _i++;
+            return _add( Op::NOT, Type::BOOL, _unary());
+        }   // end if
+        if ( _accept( "-"))
+            return _add( Op::NEG, Type::NUM, _numeric(_unary()));
+        return _primary();
+    }   // end _unary
+
+    // Parse a parenthesised list of numeric arguments returning their node indices.
+    std::vector<int> _args()
+    {
+        std::vector<int> args;
+        _expect( "(");
+        if ( !_accept( ")"))
+        {
+            do { args.push_back( _numeric(_or()));} while ( _accept( ","));
+            _expect( ")");
+        }   // end if
+        return args;
+    }   // end _args
+
+    int _primary()
+    {
+        const Token &t = _next();
+        if ( t.kind == Token::NUMBER)
+            return _add( Op::NUM, Type::NUM, -1, -1, t.num);
+        if ( t.kind == Token::SYMBOL && t.text == "(")
+        {
+            const int n = _or();
+            _expect( ")");
+            return n;
+        }   // end if
+        if ( t.kind != Token::NAME)
+            fail( QString( "unexpected '%1'").arg(t.text));
+
+        if ( t.text == "true" || t.text == "false")
+            return _add( Op::NUM, Type::BOOL, -1, -1, t.text == "true" ? 1 : 0);
+        if ( t.text == _params[0])
+            return _add( Op::AGE, Type::NUM);
+        if ( t.text == "math")
+            return _math();
+        for ( int lat = 0; lat < 3; ++lat)
+            if ( t.text == _params[lat+1])
+                return _query( lat);
+        fail( QString( "unsupported name '%1'").arg(t.text));
+        return -1;
+    }   // end _primary
+
+    int _math()
+    {
+        _expect( ".");
+        const QString fn = _next().text;
+        const std::vector<int> args = _args();
+        if ( fn == "abs" && args.size() == 1)
+            return _add( Op::ABS, Type::NUM, args[0]);
+        if ( fn == "sqrt" && args.size() == 1)
+            return _add( Op::SQRT, Type::NUM, args[0]);
+        if ( fn == "min" && args.size() == 2)
+            return _add( Op::MIN, Type::NUM, args[0], args[1]);
+        if ( fn == "max" && args.size() == 2)
+            return _add( Op::MAX, Type::NUM, args[0], args[1]);
+        fail( QString( "unsupported function math.%1").arg(fn));
+        return -1;
+    }   // end _math
+
+    // Check that the dimension argument at index i (if given) is a literal integer in range for
+    // the metric (if it's loaded) returning its node. Anything else is left to Lua to handle.
+    int _dimension( const std::vector<int> &args, size_t i, int mid)
+    {
+        if ( i >= args.size())
+            return -1;
+        const Node &nd = _pe._nodes[size_t(args[i])];
+        if ( nd.op != Op::NUM || nd.type != Type::NUM || nd.num < 0 || nd.num != std::floor(nd.num))
+            fail( "expected a literal integer dimension");
+        const MC *mc = MM::cmetric( mid);
+        if ( mc && size_t(nd.num) >= mc->dims())
+            fail( QString( "dimension %1 out of range for metric %2").arg(nd.num).arg(mid));
+        return args[i];
+    }   // end _dimension
+
+    // Parse "<set>:metric(<id>):<method>(<args>)"
+    int _query( int lat)
+    {
+        _expect( ":");
+        _expectName( "metric");
+        _expect( "(");
+        const Token &idt = _next();
+        if ( idt.kind != Token::NUMBER || idt.num != std::floor(idt.num))
+            fail( "expected a literal metric id");
+        const int mid = int(idt.num);
+        _expect( ")");
+        _expect( ":");
+        const QString method = _next().text;
+        const std::vector<int> args = _args();
+        _pe._mids.insert( mid);
+
+        if ( (method == "zscore" || method == "mean") && (args.size() == 1 || args.size() == 2))
+            return _add( method == "zscore" ? Op::ZSCORE : Op::MEAN, Type::NUM, args[0], _dimension( args, 1, mid), 0, lat, mid);
+        if ( method == "value" && args.size() <= 1)
+            return _add( Op::VALUE, Type::NUM, -1, _dimension( args, 0, mid), 0, lat, mid);
+        if ( method == "ndims" && args.empty())
+            return _add( Op::NDIMS, Type::NUM, -1, -1, 0, lat, mid);
+        fail( QString( "unsupported metric query '%1'").arg(method));
+        return -1;
+    }   // end _query
+};  // end class
+
+
+PhenotypeExpression::PhenotypeExpression() : _root(-1) {}
+
+PhenotypeExpression::~PhenotypeExpression() {}
+
+
+PhenotypeExpression::Ptr PhenotypeExpression::compile( const QString &fnsrc, QString *err)
+{
+    std::shared_ptr<PhenotypeExpression> pe( new PhenotypeExpression);
+    try
+    {
+        Parser( fnsrc, *pe).parseFunction();
+    }   // end try
+    catch ( const CompileError &e)
+    {
+        if ( err)
+            *err = e.what();
+        return nullptr;
+    }   // end catch
+    return pe;
+}   // end compile
+
+
+bool PhenotypeExpression::evaluate( float age, const MetricSet &mlat, const MetricSet &llat, const MetricSet &rlat,
+                                    const StatsManager::LateralZScores *zs) const
+{
+    const MetricSet *sets[3] = {&mlat, &llat, &rlat};
+    double v = 0;
+    return _root >= 0 && _eval( _root, age, sets, zs, v) && v != 0;
+}   // end evaluate
+
+
+// Evaluate node n into v returning false if a measurement (or dimension) is missing. Boolean
+// values are 0 or 1 and only false is falsy since numbers are always truthy in Lua.
+bool PhenotypeExpression::_eval( int n, float age, const MetricSet *sets[3], const StatsManager::LateralZScores *zs, double &v) const
+{
+    const Node &nd = _nodes[size_t(n)];
+    double a = 0;
+    double b = 0;
+    const auto truthy = [this]( int i, double x){ return _nodes[size_t(i)].type == Type::NUM || x != 0;};
+
+    switch ( nd.op)
+    {
+        case Op::NUM:
+            v = nd.num;
+            return true;
+        case Op::AGE:
+            v = age;
+            return true;
+        case Op::ZSCORE:
+        case Op::MEAN:
+        case Op::VALUE:
+        case Op::NDIMS:
+        {
+            const MetricSet &mset = *sets[nd.lat];
+            if ( !mset.hasMetric( nd.mid))
+                return false;
+            const MetricValue &mv = mset.metric( nd.mid);
+            if ( nd.op == Op::NDIMS)
+            {
+                v = double( mv.ndims());
+                return true;
+            }   // end if
+            if ( nd.b >= 0 && !_eval( nd.b, age, sets, zs, b))
+                return false;
+            if ( b < 0 || size_t(b) >= mv.ndims())
+                return false;
+            const size_t i = size_t(b);
+            if ( nd.op == Op::VALUE)
+                v = mv.value(i);
+            else
+            {
+                if ( !_eval( nd.a, age, sets, zs, a))
+                    return false;
+                if ( nd.op == Op::MEAN)
+                    v = mv.mean( float(a), i);
+                else if ( zs && float(a) == age && (*zs)[nd.lat].count( nd.mid) > 0)
+                    v = (*zs)[nd.lat].at( nd.mid).at(i);   // Precalculated at the evaluation age
+                else
+                    v = mv.zscore( float(a), i);
+            }   // end else
+            return true;
+        }   // end case
+        case Op::AND:   // Short circuits like Lua
+            if ( !_eval( nd.a, age, sets, zs, a))
+                return false;
+            if ( !truthy( nd.a, a))
+            {
+                v = a;
+                return true;
+            }   // end if
+            return _eval( nd.b, age, sets, zs, v);
+        case Op::OR:
+            if ( !_eval( nd.a, age, sets, zs, a))
+                return false;
+            if ( truthy( nd.a, a))
+            {
+                v = a;
+                return true;
+            }   // end if
+            return _eval( nd.b, age, sets, zs, v);
+        case Op::NOT:
+            if ( !_eval( nd.a, age, sets, zs, a))
+                return false;
+            v = truthy( nd.a, a) ? 0 : 1;
+            return true;
+        default:
+            break;
+    }   // end switch
+
+    // Remaining operators evaluate all of their operands
+    if ( nd.a >= 0 && !_eval( nd.a, age, sets, zs, a))
+        return false;
+    if ( nd.b >= 0 && !_eval( nd.b, age, sets, zs, b))
+        return false;
+
+    switch ( nd.op)
+    {
+        case Op::NEG:  v = -a; break;
+        case Op::ADD:  v = a + b; break;
+        case Op::SUB:  v = a - b; break;
+        case Op::MUL:  v = a * b; break;
+        case Op::DIV:  v = a / b; break;
+        case Op::LT:   v = a < b; break;
+        case Op::LE:   v = a <= b; break;
+        case Op::GT:   v = a > b; break;
+        case Op::GE:   v = a >= b; break;
+        case Op::EQ:   v = a == b; break;
+        case Op::NE:   v = a != b; break;
+        case Op::ABS:  v = std::fabs(a); break;
+        case Op::SQRT: v = std::sqrt(a); break;
+        case Op::MIN:  v = std::min(a,b); break;
+        case Op::MAX:  v = std::max(a,b); break;
+        default:
+            assert(false);
+            return false;
+    }   // end switch
+    return true;
+}   // end _eval
@@ -17,6 +17,9 @@
 
 #include <Metric/PhenotypeManager.h>
 #include <Metric/MetricManager.h>
+#include <Metric/StatsManager.h>
+#include <FaceModel.h>
+#include <FaceTools.h>
 #include <QFile>
 #include <QDir>
 #include <rlib/FileIO.h>
@@ -25,6 +28,7 @@
 using FaceTools::Metric::PhenotypeManager;
 using FaceTools::Metric::Phenotype;
 using FaceTools::FM;
+using SM = FaceTools::Metric::StatsManager;
 
 // Static definitions
 IntSet PhenotypeManager::_ids;
@@ -128,14 +132,18 @@ int PhenotypeManager::load( const QString& sdir)
         return -1;
     }   // end if
 
+    // Each term has its own Lua state so they can be loaded concurrently.
     const QStringList fnames = hdir.entryList( QDir::Files | QDir::Readable, QDir::Type | QDir::Name);
+    std::vector<Phenotype::Ptr> hpos( size_t( fnames.size()));
+    parallelFor( hpos.size(), [&]( size_t i){ hpos[i] = Phenotype::load( hdir.absoluteFilePath( fnames.at(int(i))));}, 8);
+
     int lrecs = 0;
-    for ( const QString& fname : fnames)
+    for ( int i = 0; i < fnames.size(); ++i)
     {
-        Phenotype::Ptr hpo = Phenotype::load( hdir.absoluteFilePath(fname));
+        Phenotype::Ptr hpo = hpos[size_t(i)];
         if ( !hpo)
         {
-            std::cerr << "[WARN] FaceTools::Metric::PhenotypeManager::load: Error loading Lua script " << fname.toStdString() << std::endl;
+            std::cerr << "[WARN] FaceTools::Metric::PhenotypeManager::load: Error loading Lua script " << fnames.at(i).toStdString() << std::endl;
             continue;
         }   // end else
 
@@ -165,19 +173,59 @@ int PhenotypeManager::load( const QString& sdir)
 }   // end load
 
 
+namespace {
+
+// Get the z-scores at the model's age of the assessment's medial, left and right metric sets
+// all at once rather than having each phenotype look them up individually.
+SM::LateralZScores zscores( const FM &fm, int aid)
+{
+    FaceTools::FaceAssessment::CPtr ass = aid < 0 ? fm.currentAssessment() : fm.assessment(aid);
+    return { SM::zscores( &fm, ass->cmetrics(FaceTools::MID), fm.age()),
+             SM::zscores( &fm, ass->cmetrics(FaceTools::LEFT), fm.age()),
+             SM::zscores( &fm, ass->cmetrics(FaceTools::RIGHT), fm.age())};
+}   // end zscores
+
+}   // end namespace
+
+
 IntSet PhenotypeManager::discover( const FM &fm, int aid)
 {
+    const SM::LateralZScores zs = zscores( fm, aid);
+
     IntSet dids;
     for ( const auto& p : _hpos)
     {
         Phenotype::Ptr hpo = p.second;
-        if ( hpo->isPresent(fm, aid))
+        if ( hpo->isPresent(fm, aid, &zs))
             dids.insert( hpo->id());
     }   // end for
     return dids;
 }   // end discover
 
 
+IntSet PhenotypeManager::rediscover( const FM &fm, const IntSet &dids, const IntSet &mids, int aid)
+{
+    IntSet hids;
+    for ( int mid : mids)
+    {
+        const IntSet &mhids = byMetric(mid);
+        hids.insert( mhids.begin(), mhids.end());
+    }   // end for
+
+    const SM::LateralZScores zs = zscores( fm, aid);
+
+    IntSet ndids = dids;
+    for ( int hid : hids)
+    {
+        if ( _hpos.at(hid)->isPresent(fm, aid, &zs))
+            ndids.insert(hid);
+        else
+            ndids.erase(hid);
+    }   // end for
+    return ndids;
+}   // end rediscover
+
+
 QString PhenotypeManager::htmlLinkString( int id)
 {
     const QString fid = formattedId(id);
@@ -86,8 +86,7 @@ float RegionMetricType::update( size_t k, const FM *fm, const std::vector<Vec3f>
     // Copy the ordered boundary vertices into the RegionMeasure struct,
     // untransforming them from the model transform along the way.
     const Mat4f &iT = fm->inverseTransformMatrix();
-    _regionInfo[fm].resize( std::max( _regionInfo[fm].size(), k+1));
-    RegionMeasure &rm = _regionInfo[fm][k];
+    RegionMeasure rm;
     rm.points.resize(nperim);
     int i = 0;
     for ( const int vidx : blist)
@@ -104,5 +103,6 @@ float RegionMetricType::update( size_t k, const FM *fm, const std::vector<Vec3f>
         pi = i;
     }   // end for
 
+    _regionInfo.set( fm, k, rm);
     return area > 0 ? pow(perim,2)/area : 0;
 }   // end update
@@ -128,6 +128,31 @@ StatsManager::RPtr StatsManager::stats( int mid, const FM *fm)
 }   // end stats
 
 
+StatsManager::ZScores StatsManager::zscores( const FM *fm, const MetricSet &mset, float age)
+{
+    ZScores zs;
+    QReadLocker lock( &_lock);
+    const auto mit = fm ? _modelGDs.find(fm) : _modelGDs.end();
+    for ( int mid : mset.ids())
+    {
+        const MetricValue &mv = mset.metric(mid);
+        std::vector<float> &mzs = zs[mid];
+        mzs.resize( mv.ndims(), 0.0f);
+
+        const GD *gd = nullptr;
+        if ( !fm || usingDefaultMetricStats( mid))
+            gd = defaultMetricStats( mid);
+        else if ( mit != _modelGDs.end() && mit->second.count(mid) > 0)
+            gd = mit->second.at(mid);
+
+        if ( gd)
+            for ( size_t i = 0; i < mzs.size(); ++i)
+                mzs[i] = gd->zscore( age, mv.value(i), i);
+    }   // end for
+    return zs;
+}   // end zscores
+
+
 void StatsManager::updateStatsForModel( const FM &fm)
 {
     _lock.lockForWrite();
@@ -135,8 +160,10 @@ void StatsManager::updateStatsForModel( const FM &fm)
     for ( int mid : mids)
     {
         const GrowthDataRanker &gdranker = MM::cmetric(mid)->growthData();
-        const GrowthDataSources gds = gdranker.compatible( &fm);
-        _modelGDs[&fm][mid] = gdranker.bestMatch( gds, &fm);
+        const GD *gd = gdranker.bestMatch( &fm);
+        if ( gd)
+            gd->prepareLookups();
+        _modelGDs[&fm][mid] = gd;
     }   // end for
     _lock.unlock();
 }   // end updateStatsForModel
@@ -164,6 +191,7 @@ void StatsManager::setDefaultMetricStats( int mid, const GD *gd)
 {
     assert(mid >= 0);
     assert(gd);
+    gd->prepareLookups();
     _metricGDs[mid] = gd;
 }   // end setDefaultMetricStats
 
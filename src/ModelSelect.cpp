@@ -157,17 +157,36 @@ void ModelSelect::setViewAngle( double v)
 FV* ModelSelect::selectedView() { return _selectNotifier()->selected();}
 
 
-FM::RPtr ModelSelect::selectedModelScopedRead()
+namespace { thread_local FM *_boundModel = nullptr;}
+
+FM* ModelSelect::bindModel( FM *fm)
+{
+    FM *pfm = _boundModel;
+    _boundModel = fm;
+    return pfm;
+}   // end bindModel
+
+
+FM* ModelSelect::selectedModel()
 {
+    if ( _boundModel)
+        return _boundModel;
     const FV *fv = selectedView();
-    return fv ? fv->data()->scopedReadLock() : nullptr;
+    return fv ? fv->data() : nullptr;
+}   // end selectedModel
+
+
+FM::RPtr ModelSelect::selectedModelScopedRead()
+{
+    const FM *fm = selectedModel();
+    return fm ? fm->scopedReadLock() : nullptr;
 }   // end selectedModelScopedRead
 
 
 FM::WPtr ModelSelect::selectedModelScopedWrite()
 {
-    FV *fv = selectedView();
-    return fv ? fv->data()->scopedWriteLock() : nullptr;
+    FM *fm = selectedModel();
+    return fm ? fm->scopedWriteLock() : nullptr;
 }   // end selectedModelScopedWrite
 
 
@@ -25,6 +25,7 @@
 #include <Vis/ColourVisualisation.h>
 #include <Widget/ChartDialog.h>
 #include <Ethnicities.h>
+#include <LuaLoader.h>
 #include <FaceModel.h>
 #include <FaceTools.h>
 #include <U3DCache.h>
@@ -290,9 +291,7 @@ Report::Ptr Report::load( const QString& fname)
         QFile file(fname);
         if ( file.open(QIODevice::ReadOnly | QIODevice::Text))  // Open for read only text
         {
-            QTextStream in(&file);
-            const QString code = in.readAll();
-            report->_lua.script( code.toStdString());
+            LuaLoader::script( report->_lua, file.readAll(), fname);
             loadedOk = true;
         }   // end if
     }   // end try
@@ -0,0 +1,226 @@
+/************************************************************************
+ * Copyright (C) 2021 SIS Research Ltd & Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+
+#include <SurfaceDataArchive.h>
+#include <boost/functional/hash.hpp>
+#include <cstring>
+#include <cassert>
+using FaceTools::SurfaceDataArchive;
+using FaceTools::FM;
+
+std::unordered_map<const FM*, std::unordered_map<QString, SurfaceDataArchive::Held> > SurfaceDataArchive::_held;
+bool SurfaceDataArchive::_enabled(true);
+QMutex SurfaceDataArchive::_lock;
+
+
+namespace {
+static const char MAGIC[4] = {'R','3','D','S'};
+static const uint32_t VERSION = 1;
+static const uint32_t MAX_COMPONENTS = 16;
+
+void putU32( std::vector<char> &buf, uint32_t v)
+{
+    buf.push_back( char(v & 0xff));
+    buf.push_back( char((v >> 8) & 0xff));
+    buf.push_back( char((v >> 16) & 0xff));
+    buf.push_back( char((v >> 24) & 0xff));
+}   // end putU32
+
+void putF32( std::vector<char> &buf, float f)
+{
+    uint32_t v;
+    std::memcpy( &v, &f, sizeof(float));
+    putU32( buf, v);
+}   // end putF32
+
+
+bool getU32( std::istream &is, uint32_t &v)
+{
+    unsigned char b[4] = {0,0,0,0};
+    if ( !is.read( reinterpret_cast<char*>(b), 4))
+        return false;
+    v = uint32_t(b[0]) | (uint32_t(b[1]) << 8) | (uint32_t(b[2]) << 16) | (uint32_t(b[3]) << 24);
+    return true;
+}   // end getU32
+
+
+// Returns the number of bytes remaining to be read from the stream (zero if unknown).
+size_t remaining( std::istream &is)
+{
+    const std::streampos pos = is.tellg();
+    if ( pos < 0 || !is.seekg( 0, std::ios::end))
+        return 0;
+    const std::streampos end = is.tellg();
+    is.seekg( pos);
+    return end > pos ? size_t( end - pos) : 0;
+}   // end remaining
+
+}   // end namespace
+
+
+void SurfaceDataArchive::setEnabled( bool v)
+{
+    QMutexLocker lock( &_lock);
+    _enabled = v;
+}   // end setEnabled
+
+
+bool SurfaceDataArchive::isEnabled()
+{
+    QMutexLocker lock( &_lock);
+    return _enabled;
+}   // end isEnabled
+
+
+size_t SurfaceDataArchive::meshHash( const r3d::Mesh &mesh)
+{
+    // Per-vertex arrays are indexed by vertex ID so only meshes with sequential IDs can be matched.
+    if ( !mesh.hasSequentialIds())
+        return 0;
+
+    static const size_t HASH_NDP = 4;
+    size_t h = 0;
+    const int N = int(mesh.numVtxs());
+    for ( int i = 0; i < N; ++i)
+        r3d::hash( mesh.vtx(i), HASH_NDP, h);
+
+    const int M = int(mesh.numFaces());
+    for ( int i = 0; i < M; ++i)
+    {
+        const int* fvidxs = mesh.fvidxs(i);
+        boost::hash_combine( h, fvidxs[0]);
+        boost::hash_combine( h, fvidxs[1]);
+        boost::hash_combine( h, fvidxs[2]);
+    }   // end for
+
+    return h;
+}   // end meshHash
+
+
+bool SurfaceDataArchive::write( const Arrays &arrs, size_t hash, std::ostream &os)
+{
+    std::vector<char> buf;
+    buf.insert( buf.end(), MAGIC, MAGIC+4);
+    putU32( buf, VERSION);
+    const uint64_t h = uint64_t(hash);
+    putU32( buf, uint32_t(h & 0xffffffff));
+    putU32( buf, uint32_t(h >> 32));
+    putU32( buf, uint32_t(arrs.size()));
+
+    for ( const vtkSmartPointer<vtkFloatArray> &arr : arrs)
+    {
+        assert( arr);
+        const QByteArray nm = QByteArray( arr->GetName() ? arr->GetName() : "");
+        putU32( buf, uint32_t(nm.size()));
+        buf.insert( buf.end(), nm.begin(), nm.end());
+
+        const int nc = arr->GetNumberOfComponents();
+        const vtkIdType nt = arr->GetNumberOfTuples();
+        putU32( buf, uint32_t(nc));
+        putU32( buf, uint32_t(nt));
+        buf.reserve( buf.size() + size_t(nt) * size_t(nc) * sizeof(float));
+        const float *vals = arr->GetPointer(0);
+        for ( vtkIdType i = 0; i < nt * nc; ++i)
+            putF32( buf, vals[i]);
+    }   // end for
+
+    os.write( buf.data(), std::streamsize(buf.size()));
+    return os.good();
+}   // end write
+
+
+bool SurfaceDataArchive::read( std::istream &is, Arrays &arrs, size_t &hash, size_t ntuples)
+{
+    char magic[4];
+    if ( !is.read( magic, 4) || std::memcmp( magic, MAGIC, 4) != 0)
+        return false;
+
+    uint32_t vers, hlo, hhi, na;
+    if ( !getU32( is, vers) || vers > VERSION || !getU32( is, hlo) || !getU32( is, hhi) || !getU32( is, na))
+        return false;
+    hash = size_t( uint64_t(hlo) | (uint64_t(hhi) << 32));
+
+    arrs.clear();
+    for ( uint32_t i = 0; i < na; ++i)
+    {
+        uint32_t nb, nc, nt;
+        if ( !getU32( is, nb) || nb > remaining( is))
+            return false;
+        QByteArray nm( int(nb), '\0');
+        if ( nb > 0 && !is.read( nm.data(), std::streamsize(nb)))
+            return false;
+        if ( !getU32( is, nc) || !getU32( is, nt) || nc == 0 || nc > MAX_COMPONENTS)
+            return false;
+
+        // Check the sizes before allocating since they come from the file.
+        const size_t nvals = size_t(nt) * nc;
+        if ( size_t(nt) != ntuples || nvals * 4 > remaining( is))
+            return false;
+
+        vtkSmartPointer<vtkFloatArray> arr = vtkSmartPointer<vtkFloatArray>::New();
+        arr->SetName( nm.constData());
+        arr->SetNumberOfComponents( int(nc));
+        arr->SetNumberOfTuples( vtkIdType(nt));
+        std::vector<unsigned char> bytes( nvals * 4);
+        if ( nvals > 0 && !is.read( reinterpret_cast<char*>(bytes.data()), std::streamsize(bytes.size())))
+            return false;
+        float *vals = arr->GetPointer(0);
+        for ( size_t j = 0; j < nvals; ++j)
+        {
+            const unsigned char *b = &bytes[4*j];
+            const uint32_t v = uint32_t(b[0]) | (uint32_t(b[1]) << 8) | (uint32_t(b[2]) << 16) | (uint32_t(b[3]) << 24);
+            std::memcpy( &vals[j], &v, sizeof(float));
+        }   // end for
+        arrs.push_back( arr);
+    }   // end for
+
+    return true;
+}   // end read
+
+
+void SurfaceDataArchive::set( const FM *fm, const QString &store, size_t hash, const Arrays &arrs)
+{
+    QMutexLocker lock( &_lock);
+    _held[fm][store] = Held{ hash, arrs};
+}   // end set
+
+
+bool SurfaceDataArchive::take( const FM *fm, const QString &store, size_t hash, Arrays &arrs)
+{
+    QMutexLocker lock( &_lock);
+    const auto it = _held.find(fm);
+    if ( it == _held.end() || it->second.count(store) == 0)
+        return false;
+
+    const Held held = it->second.at(store);
+    it->second.erase(store);
+    if ( it->second.empty())
+        _held.erase(it);
+
+    if ( hash == 0 || held.hash != hash)
+        return false;
+    arrs = held.arrays;
+    return true;
+}   // end take
+
+
+void SurfaceDataArchive::purge( const FM *fm)
+{
+    QMutexLocker lock( &_lock);
+    _held.erase(fm);
+}   // end purge
@@ -0,0 +1,211 @@
+/************************************************************************
+ * Copyright (C) 2021 SIS Research Ltd & Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+#include <SurfaceDataBudget.h>
+#include <cassert>
+using FaceTools::SurfaceDataBudget;
+using FaceTools::FM;
+
+std::list<SurfaceDataBudget::Entry> SurfaceDataBudget::_lru;
+std::map<SurfaceDataBudget::Key, std::list<SurfaceDataBudget::Entry>::iterator> SurfaceDataBudget::_entries;
+std::vector<std::pair<QString, SurfaceDataBudget::Evictor> > SurfaceDataBudget::_stores;
+std::unordered_map<QString, SurfaceDataBudget::Recalculator> SurfaceDataBudget::_recalcs;
+std::vector<size_t> SurfaceDataBudget::_usage;
+size_t SurfaceDataBudget::_total(0);
+size_t SurfaceDataBudget::_budget( size_t(1024) << 20);
+size_t SurfaceDataBudget::_nevicted(0);
+QMutex SurfaceDataBudget::_lock;
+
+
+int SurfaceDataBudget::addStore( const QString &name, const Evictor &ev)
+{
+    QMutexLocker lock( &_lock);
+    _stores.push_back( std::make_pair( name, ev));
+    _usage.push_back(0);
+    return int(_stores.size()) - 1;
+}   // end addStore
+
+
+void SurfaceDataBudget::setRecalculator( const QString &name, const Recalculator &rc)
+{
+    QMutexLocker lock( &_lock);
+    _recalcs[name] = rc;
+}   // end setRecalculator
+
+
+void SurfaceDataBudget::recalculate( int store, const FM *fm0, const FM *fm1)
+{
+    _lock.lock();
+    const QString &name = _stores.at(size_t(store)).first;
+    const Recalculator rc = _recalcs.count(name) > 0 ? _recalcs.at(name) : nullptr;
+    _lock.unlock();
+    if ( rc)
+        rc( fm0, fm1);
+}   // end recalculate
+
+
+void SurfaceDataBudget::setBudget( size_t b)
+{
+    _lock.lock();
+    _budget = b;
+    _lock.unlock();
+    _evict();
+}   // end setBudget
+
+
+size_t SurfaceDataBudget::budget()
+{
+    QMutexLocker lock( &_lock);
+    return _budget;
+}   // end budget
+
+
+size_t SurfaceDataBudget::usage()
+{
+    QMutexLocker lock( &_lock);
+    return _total;
+}   // end usage
+
+
+size_t SurfaceDataBudget::usage( int store)
+{
+    QMutexLocker lock( &_lock);
+    return _usage.at(size_t(store));
+}   // end usage
+
+
+size_t SurfaceDataBudget::count()
+{
+    QMutexLocker lock( &_lock);
+    return _entries.size();
+}   // end count
+
+
+QStringList SurfaceDataBudget::storeNames()
+{
+    QMutexLocker lock( &_lock);
+    QStringList names;
+    for ( const auto &s : _stores)
+        names << s.first;
+    return names;
+}   // end storeNames
+
+
+size_t SurfaceDataBudget::evictions()
+{
+    QMutexLocker lock( &_lock);
+    return _nevicted;
+}   // end evictions
+
+
+void SurfaceDataBudget::add( int store, const FM *fm0, const FM *fm1, size_t nbytes)
+{
+    _lock.lock();
+    const Key key( store, fm0, fm1);
+    if ( _entries.count(key) > 0)
+    {
+        const std::list<Entry>::iterator it = _entries.at(key);
+        _total -= it->bytes;
+        _usage[size_t(store)] -= it->bytes;
+        _lru.erase( it);
+    }   // end if
+    _lru.push_front( Entry{ store, fm0, fm1, nbytes});
+    _entries[key] = _lru.begin();
+    _total += nbytes;
+    _usage[size_t(store)] += nbytes;
+    _lock.unlock();
+    _evict();
+}   // end add
+
+
+void SurfaceDataBudget::touch( int store, const FM *fm0, const FM *fm1)
+{
+    QMutexLocker lock( &_lock);
+    const Key key( store, fm0, fm1);
+    if ( _entries.count(key) > 0)
+        _lru.splice( _lru.begin(), _lru, _entries.at(key));
+}   // end touch
+
+
+void SurfaceDataBudget::remove( int store, const FM *fm0, const FM *fm1)
+{
+    QMutexLocker lock( &_lock);
+    const Key key( store, fm0, fm1);
+    if ( _entries.count(key) > 0)
+    {
+        const std::list<Entry>::iterator it = _entries.at(key);
+        _total -= it->bytes;
+        _usage[size_t(store)] -= it->bytes;
+        _lru.erase( it);
+        _entries.erase( key);
+    }   // end if
+}   // end remove
+
+
+void SurfaceDataBudget::_evict()
+{
+    std::vector<Entry> evicted;
+    _lock.lock();
+    // Never evict the most recently used entry since it's likely just been added,
+    // and skip the entries of stores that have no way to recalculate them.
+    auto it = _lru.end();
+    while ( _budget > 0 && _total > _budget && _lru.size() > 1 && --it != _lru.begin())
+    {
+        if ( _recalcs.count( _stores.at(size_t(it->store)).first) == 0)
+            continue;
+        const Entry e = *it;
+        it = _lru.erase( it);
+        _entries.erase( Key( e.store, e.fm0, e.fm1));
+        _total -= e.bytes;
+        _usage[size_t(e.store)] -= e.bytes;
+        _nevicted++;
+        evicted.push_back( e);
+    }   // end while
+    _lock.unlock();
+
+    // Evictors take their own store locks so are called after releasing the budget lock.
+    for ( const Entry &e : evicted)
+    {
+        if ( !_stores.at(size_t(e.store)).second( e.fm0, e.fm1))
+        {
+            // In use so keep it (this may leave usage over budget until the next eviction)
+            QMutexLocker lock( &_lock);
+            const Key key( e.store, e.fm0, e.fm1);
+            if ( _entries.count(key) == 0)
+            {
+                _lru.push_front( e);
+                _entries[key] = _lru.begin();
+                _total += e.bytes;
+                _usage[size_t(e.store)] += e.bytes;
+                _nevicted--;
+            }   // end if
+        }   // end if
+    }   // end for
+}   // end _evict
+
+
+size_t SurfaceDataBudget::bytes( vtkDataArray *arr)
+{
+    return arr ? size_t( arr->GetActualMemorySize()) * 1024 : 0;    // VTK reports KiB
+}   // end bytes
+
+
+size_t SurfaceDataBudget::bytes( const r3d::Mesh &mesh)
+{
+    // Approximate since includes the lookup structures as well as the raw data.
+    return mesh.numVtxs() * (2 * sizeof(Vec3f) + 48) + mesh.numFaces() * (3 * sizeof(int) + 48);
+}   // end bytes
@@ -0,0 +1,49 @@
+/************************************************************************
+ * Copyright (C) 2021 SIS Research Ltd & Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+
+#include <TaskState.h>
+#include <algorithm>
+using FaceTools::TaskState;
+
+namespace { thread_local TaskState *_current = nullptr;}
+
+
+TaskState::Ptr TaskState::create() { return Ptr( new TaskState);}
+
+
+TaskState::TaskState() : _cancelled(false), _nsteps(0), _ndone(0) {}
+
+
+float TaskState::progress() const
+{
+    const size_t n = _nsteps;
+    if ( n == 0)
+        return 0.0f;
+    return std::min( 1.0f, float(_ndone) / n);
+}   // end progress
+
+
+TaskState* TaskState::current() { return _current;}
+
+
+TaskState* TaskState::setCurrent( TaskState *ts)
+{
+    TaskState *prev = _current;
+    _current = ts;
+    return prev;
+}   // end setCurrent
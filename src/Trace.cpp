@@ -0,0 +1,236 @@
+/************************************************************************
+ * Copyright (C) 2021 SIS Research Ltd & Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+
+#include <Trace.h>
+#include <QCoreApplication>
+#include <QThread>
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cstdio>
+using FaceTools::Trace;
+
+std::atomic<bool> Trace::_enabled(false);
+size_t Trace::_capacity(200000);
+std::deque<Trace::Record> Trace::_events;
+std::unordered_map<int, std::string> Trace::_tnames;
+QMutex Trace::_lock;
+
+
+namespace {
+using Clock = std::chrono::steady_clock;
+const Clock::time_point ORIGIN = Clock::now();
+
+std::string toStd( const QString &s) { return s.toUtf8().toStdString();}
+
+void writeJSONString( std::ostream &os, const std::string &s)
+{
+    os << '"';
+    for ( const char c : s)
+    {
+        switch (c)
+        {
+            case '"': os << "\\\""; break;
+            case '\\': os << "\\\\"; break;
+            case '\n': os << "\\n"; break;
+            case '\r': os << "\\r"; break;
+            case '\t': os << "\\t"; break;
+            default:
+                if ( static_cast<unsigned char>(c) < 0x20)
+                {
+                    char buf[8];
+                    snprintf( buf, sizeof(buf), "\\u%04x", c);
+                    os << buf;
+                }   // end if
+                else
+                    os << c;
+        }   // end switch
+    }   // end for
+    os << '"';
+}   // end writeJSONString
+
+}   // end namespace
+
+
+void Trace::setCapacity( size_t n)
+{
+    QMutexLocker lock( &_lock);
+    _capacity = n;
+    while ( _events.size() > _capacity)
+        _events.pop_front();
+}   // end setCapacity
+
+
+int64_t Trace::now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>( Clock::now() - ORIGIN).count();
+}   // end now
+
+
+int Trace::_threadId()
+{
+    static std::atomic<int> nextId(1);
+    thread_local int tid = 0;
+    if ( tid == 0)
+    {
+        tid = nextId++;
+        const QCoreApplication *app = QCoreApplication::instance();
+        std::string tname;
+        if ( app && QThread::currentThread() == app->thread())
+            tname = "GUI";
+        else
+            tname = "Worker " + std::to_string(tid);
+        QMutexLocker lock( &_lock);
+        _tnames[tid] = tname;
+    }   // end if
+    return tid;
+}   // end _threadId
+
+
+void Trace::_add( Record &&ev)
+{
+    QMutexLocker lock( &_lock);
+    if ( _capacity == 0)
+        return;
+    if ( _events.size() >= _capacity)
+        _events.pop_front();
+    _events.push_back( std::move(ev));
+}   // end _add
+
+
+void Trace::addSpan( const char *cat, const std::string &name, uintptr_t id, int64_t t0)
+{
+    if ( !_enabled)
+        return;
+    const int tid = _threadId();
+    _add( Record{ 'b', cat, name, "", t0, 0, tid, id});
+    _add( Record{ 'e', cat, name, "", now(), 0, tid, id});
+}   // end addSpan
+
+
+void Trace::clear()
+{
+    QMutexLocker lock( &_lock);
+    _events.clear();
+}   // end clear
+
+
+bool Trace::write( const QString &fpath)
+{
+    _lock.lock();
+    const std::deque<Record> events = _events;   // Write without holding the lock
+    const std::unordered_map<int, std::string> tnames = _tnames;
+    _lock.unlock();
+
+    std::ofstream ofs( fpath.toLocal8Bit().toStdString());
+    if ( !ofs.is_open())
+    {
+        std::cerr << "[WARN] FaceTools::Trace::write: Unable to open " << fpath.toStdString() << std::endl;
+        return false;
+    }   // end if
+
+    ofs << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for ( const auto &p : tnames)
+    {
+        ofs << (first ? "\n" : ",\n");
+        first = false;
+        ofs << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << p.first << ",\"args\":{\"name\":";
+        writeJSONString( ofs, p.second);
+        ofs << "}}";
+    }   // end for
+
+    for ( const Record &ev : events)
+    {
+        ofs << (first ? "\n" : ",\n");
+        first = false;
+        ofs << "{\"name\":";
+        writeJSONString( ofs, ev.name);
+        ofs << ",\"cat\":";
+        writeJSONString( ofs, ev.cat);
+        ofs << ",\"ph\":\"" << ev.ph << "\",\"ts\":" << ev.ts;
+        if ( ev.ph == 'X')
+            ofs << ",\"dur\":" << ev.dur;
+        else
+            ofs << ",\"id\":\"0x" << std::hex << ev.id << std::dec << "\"";
+        ofs << ",\"pid\":1,\"tid\":" << ev.tid;
+        if ( !ev.detail.empty())
+        {
+            ofs << ",\"args\":{\"detail\":";
+            writeJSONString( ofs, ev.detail);
+            ofs << "}";
+        }   // end if
+        ofs << "}";
+    }   // end for
+
+    ofs << "\n]}" << std::endl;
+    if ( !ofs)
+    {
+        std::cerr << "[WARN] FaceTools::Trace::write: Failed writing " << fpath.toStdString() << std::endl;
+        return false;
+    }   // end if
+    return true;
+}   // end write
+
+
+Trace::Scope::Scope( const char *cat, const char *name, const char *detail)
+    : _cat(cat), _t0(0), _on(_enabled)
+{
+    if ( _on)
+    {
+        _name = name;
+        if ( detail)
+            _detail = detail;
+        _t0 = now();
+    }   // end if
+}   // end ctor
+
+
+Trace::Scope::Scope( const char *cat, const std::string &name, const char *detail)
+    : _cat(cat), _t0(0), _on(_enabled)
+{
+    if ( _on)
+    {
+        _name = name;
+        if ( detail)
+            _detail = detail;
+        _t0 = now();
+    }   // end if
+}   // end ctor
+
+
+Trace::Scope::Scope( const char *cat, const char *name, const QString &detail)
+    : _cat(cat), _t0(0), _on(_enabled)
+{
+    if ( _on)
+    {
+        _name = name;
+        _detail = toStd( detail);
+        _t0 = now();
+    }   // end if
+}   // end ctor
+
+
+Trace::Scope::~Scope()
+{
+    if ( _on)
+    {
+        const int64_t t1 = now();
+        _add( Record{ 'X', _cat, std::move(_name), std::move(_detail), _t0, t1 - _t0, _threadId(), 0});
+    }   // end if
+}   // end dtor
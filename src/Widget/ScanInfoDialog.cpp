@@ -145,7 +145,8 @@ QTools::TreeModel* createEthnicityComboBoxModel()
 ScanInfoDialog::ScanInfoDialog( QWidget *parent) :
     QDialog(parent), _ui(new Ui::ScanInfoDialog),
     _dialogRootTitle( parent->windowTitle() + " | Assessment Information"),
-    _focusOutSignaller( QEvent::FocusOut, false)
+    _focusOutSignaller( QEvent::FocusOut, false),
+    _hfm(nullptr), _haid(-1), _partial(false)
 {
     _ui->setupUi(this);
 
@@ -507,6 +508,13 @@ void ScanInfoDialog::refreshAssessment()
 }   // end refreshAssessment
 
 
+void ScanInfoDialog::setUpdatedMetrics( const IntSet &mids)
+{
+    _umids.insert( mids.begin(), mids.end());  // Merge if updated more than once before refreshing
+    _partial = true;
+}   // end setUpdatedMetrics
+
+
 void ScanInfoDialog::refreshNotableHPOs()
 {
     const FM *fm = MS::selectedModel();
@@ -517,9 +525,18 @@ void ScanInfoDialog::refreshNotableHPOs()
         msg = tr("<center><b>Detect face for phenotypic assessment</b></center>");
     else
     {
-        const IntSet hids = Metric::PhenotypeManager::discover( *fm, fm->currentAssessment()->id());
+        // Only recheck the terms affected by the updated metrics if the terms
+        // last discovered were for the same model and assessment.
+        const int aid = fm->currentAssessment()->id();
+        if ( _partial && fm == _hfm && aid == _haid)
+            _hids = Metric::PhenotypeManager::rediscover( *fm, _hids, _umids, aid);
+        else
+            _hids = Metric::PhenotypeManager::discover( *fm, aid);
+        _hfm = fm;
+        _haid = aid;
+
         QStringList lterms;
-        for ( int hid : hids)
+        for ( int hid : _hids)
             lterms << Metric::PhenotypeManager::htmlLinkString(hid);
         lterms.sort();  // Sort into alphanumeric order
 
@@ -528,6 +545,10 @@ void ScanInfoDialog::refreshNotableHPOs()
         else
             msg = tr("<b>No noted phenotypic traits found.</b>");
     }   // end else
+    if ( !fm || !fm->hasLandmarks())
+        _hfm = nullptr;
+    _partial = false;
+    _umids.clear();
     _ui->hpoTermsTextBrowser->document()->setHtml(msg);
     _ui->hpoTermsTextBrowser->moveCursor( QTextCursor::Start);
 }   // end refreshNotableHPOs
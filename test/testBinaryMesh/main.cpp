@@ -0,0 +1,135 @@
+/************************************************************************
+ * Copyright (C) 2021 SIS Research Ltd & Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+
+/**
+ * Round trips meshes through the binary mesh format checking that vertices, faces,
+ * textures and UVs are read back as written and that corrupt data is rejected.
+ */
+
+#include <FileIO/BinaryMesh.h>
+#include <QTemporaryDir>
+#include <opencv2/core.hpp>
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+using namespace FaceTools;
+using r3d::Mesh;
+using r3d::Vec2f;
+using r3d::Vec3f;
+
+
+namespace {
+
+// A textured grid of N x N vertices.
+Mesh::Ptr makeMesh( int N)
+{
+    Mesh::Ptr mesh = Mesh::create();
+    for ( int i = 0; i < N; ++i)
+        for ( int j = 0; j < N; ++j)
+            mesh->addVertex( Vec3f( float(i), float(j), 0.1f * float(i*j)));
+
+    cv::Mat tx( 16, 16, CV_8UC3);
+    cv::randu( tx, cv::Scalar::all(0), cv::Scalar::all(255));
+    const int mid = mesh->addMaterial( tx);
+
+    const float d = 1.0f / float(N-1);
+    for ( int i = 0; i < N-1; ++i)
+    {
+        for ( int j = 0; j < N-1; ++j)
+        {
+            const int v = i*N + j;
+            const int f0 = mesh->addFace( v, v+N, v+1);
+            mesh->setOrderedFaceUVs( mid, f0, Vec2f( i*d, j*d), Vec2f( (i+1)*d, j*d), Vec2f( i*d, (j+1)*d));
+            mesh->addFace( v+1, v+N, v+N+1);    // Untextured
+        }   // end for
+    }   // end for
+    return mesh;
+}   // end makeMesh
+
+
+bool sameMesh( const Mesh &m0, const Mesh &m1)
+{
+    if ( m0.numVtxs() != m1.numVtxs() || m0.numFaces() != m1.numFaces() || m0.numMats() != m1.numMats())
+        return false;
+    for ( int i = 0; i < int(m0.numVtxs()); ++i)
+        if ( m0.vtx(i) != m1.vtx(i))
+            return false;
+    for ( int i = 0; i < int(m0.numFaces()); ++i)
+    {
+        const int *f0 = m0.fvidxs(i);
+        const int *f1 = m1.fvidxs(i);
+        if ( f0[0] != f1[0] || f0[1] != f1[1] || f0[2] != f1[2])
+            return false;
+    }   // end for
+
+    const int mid0 = *m0.materialIds().begin();
+    const int mid1 = *m1.materialIds().begin();
+    if ( cv::norm( m0.texture(mid0), m1.texture(mid1), cv::NORM_INF) != 0)
+        return false;
+    if ( m0.materialFaceIds(mid0) != m1.materialFaceIds(mid1))
+        return false;
+    for ( int fid : m0.materialFaceIds(mid0))
+        for ( int i = 0; i < 3; ++i)
+            if ( m0.faceUV( fid, i) != m1.faceUV( fid, i))
+                return false;
+    return true;
+}   // end sameMesh
+
+
+bool check( bool v, const char *msg)
+{
+    std::cout << (v ? "[PASS] " : "[FAIL] ") << msg << std::endl;
+    return v;
+}   // end check
+
+}   // end namespace
+
+
+int main( int, char**)
+{
+    const Mesh::Ptr mesh = makeMesh( 20);
+    bool ok = true;
+
+    std::stringstream ss;
+    ok &= check( FileIO::writeBinaryMesh( *mesh, ss), "Write to stream");
+    const std::string bytes = ss.str();
+    std::istringstream iss( bytes);
+    const Mesh::Ptr smesh = FileIO::readBinaryMesh( iss);
+    ok &= check( smesh && sameMesh( *mesh, *smesh), "Read back from stream");
+
+    QTemporaryDir tdir;
+    const QString fpath = tdir.filePath( "mesh." + FileIO::BINARY_MESH_EXTENSION);
+    ok &= check( FileIO::writeBinaryMesh( *mesh, fpath), "Write to file");
+    const Mesh::Ptr fmesh = FileIO::readBinaryMesh( fpath);
+    ok &= check( fmesh && sameMesh( *mesh, *fmesh), "Read back from file");
+
+    std::istringstream tss( bytes.substr( 0, bytes.size() / 2));
+    ok &= check( !FileIO::readBinaryMesh( tss), "Reject truncated data");
+
+    // Claim far more vertices than there are bytes for (count follows the magic and version).
+    std::string big = bytes;
+    big[8] = big[9] = big[10] = char(0xff);
+    big[11] = char(0x7f);
+    std::istringstream bss( big);
+    ok &= check( !FileIO::readBinaryMesh( bss), "Reject oversized vertex count");
+
+    std::istringstream mss( "XXXX" + bytes.substr(4));
+    ok &= check( !FileIO::readBinaryMesh( mss), "Reject bad magic");
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}   // end main
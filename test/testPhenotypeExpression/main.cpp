@@ -0,0 +1,134 @@
+/************************************************************************
+ * Copyright (C) 2021 SIS Research Ltd & Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+
+/**
+ * Loads every HPO term definition in a directory twice - once with its determination
+ * function compiled and once running it through Lua - and checks that both versions
+ * agree on the presence of the term for a range of randomly generated measurements.
+ */
+
+#include <Metric/Phenotype.h>
+#include <Metric/MetricManager.h>
+#include <Metric/StatsManager.h>
+#include <FaceModel.h>
+#include <QCoreApplication>
+#include <QDir>
+#include <iostream>
+#include <random>
+#include <cstdlib>
+using namespace FaceTools;
+using namespace FaceTools::Metric;
+using MM = MetricManager;
+using SM = StatsManager;
+
+
+namespace {
+
+// Set random values for the given metrics on the model's current assessment.
+void setValues( FM &fm, const IntSet &mids, std::mt19937 &rng, float scale)
+{
+    std::uniform_real_distribution<float> dist( 0.0f, scale);
+    FaceAssessment::Ptr ass = fm.currentAssessment();
+    for ( int mid : mids)
+    {
+        const MC *mc = MM::cmetric( mid);
+        if ( !mc)
+            continue;
+        for ( FaceSide lat : {MID, LEFT, RIGHT})
+        {
+            if ( (lat == MID) == mc->isBilateral())
+                continue;
+            std::vector<float> vals( mc->dims());
+            for ( float &v : vals)
+                v = dist( rng);
+            ass->metrics( lat).set( MetricValue( mid, &fm, vals, false));
+        }   // end for
+    }   // end for
+}   // end setValues
+
+}   // end namespace
+
+
+int main( int argc, char **argv)
+{
+    if ( argc < 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " metricsDir hpoDir [statsDir]" << std::endl;
+        return EXIT_FAILURE;
+    }   // end if
+
+    QCoreApplication app( argc, argv);
+    if ( MM::load( argv[1]) <= 0)
+    {
+        std::cerr << "Unable to load metrics from " << argv[1] << std::endl;
+        return EXIT_FAILURE;
+    }   // end if
+    if ( argc > 3)
+        SM::load( argv[3]);
+
+    FM fm;
+    fm.setDateOfBirth( QDate( 2010, 6, 1));
+    fm.setCaptureDate( QDate( 2021, 3, 15));
+
+    static const int NTRIALS = 200;
+    std::mt19937 rng( 42);
+    int nterms = 0;
+    int ncompiled = 0;
+    int nfails = 0;
+
+    const QDir hdir( argv[2]);
+    for ( const QString &fname : hdir.entryList( QStringList("*.lua"), QDir::Files | QDir::Readable, QDir::Name))
+    {
+        const QString fpath = hdir.absoluteFilePath( fname);
+        const Phenotype::Ptr chpo = Phenotype::load( fpath, true);
+        const Phenotype::Ptr lhpo = Phenotype::load( fpath, false);
+        if ( !chpo || !lhpo)
+        {
+            std::cerr << "Failed to load " << fpath.toStdString() << std::endl;
+            nfails++;
+            continue;
+        }   // end if
+
+        nterms++;
+        if ( !chpo->isCompiled())
+            continue;
+        ncompiled++;
+
+        for ( int i = 0; i < NTRIALS; ++i)
+        {
+            // Vary the spread of values so terms with both small and large thresholds get exercised
+            setValues( fm, chpo->metrics(), rng, float(1 << (i % 8)));
+            const FaceAssessment::CPtr ass = fm.cassessment();
+            const float age = fm.age();
+            const SM::LateralZScores zs = { SM::zscores( &fm, ass->cmetrics(MID), age),
+                                            SM::zscores( &fm, ass->cmetrics(LEFT), age),
+                                            SM::zscores( &fm, ass->cmetrics(RIGHT), age)};
+            const bool lp = lhpo->isPresent( fm);
+            if ( chpo->isPresent( fm) != lp || chpo->isPresent( fm, -1, &zs) != lp)
+            {
+                std::cerr << "HP:" << chpo->id() << " (" << fname.toStdString()
+                          << ") compiled and Lua determinations differ on trial " << i << std::endl;
+                nfails++;
+                break;
+            }   // end if
+        }   // end for
+    }   // end for
+
+    std::cout << ncompiled << " of " << nterms << " terms compiled; " << nfails << " failures" << std::endl;
+    return nfails == 0 && nterms > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}   // end main
@@ -0,0 +1,104 @@
+/************************************************************************
+ * Copyright (C) 2021 SIS Research Ltd & Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+
+/**
+ * Round trips a transformed mesh through the undo spill files checking that its vertices,
+ * faces and transform are restored and that failed writes leave nothing behind.
+ */
+
+#include <Action/FaceModelState.h>
+#include <QTemporaryDir>
+#include <QFile>
+#include <iostream>
+#include <cstdlib>
+using FaceTools::Action::FaceModelState;
+using FaceTools::Mat4f;
+using r3d::Mesh;
+using r3d::Vec3f;
+
+
+namespace {
+
+Mesh::Ptr makeMesh( int N)
+{
+    Mesh::Ptr mesh = Mesh::create();
+    for ( int i = 0; i < N; ++i)
+        for ( int j = 0; j < N; ++j)
+            mesh->addVertex( Vec3f( float(i), float(j), 0.1f * float(i*j)));
+    for ( int i = 0; i < N-1; ++i)
+    {
+        for ( int j = 0; j < N-1; ++j)
+        {
+            const int v = i*N + j;
+            mesh->addFace( v, v+N, v+1);
+            mesh->addFace( v+1, v+N, v+N+1);
+        }   // end for
+    }   // end for
+
+    // Rotate about z and translate so the stored (transformed) positions differ from the originals.
+    Mat4f T = Mat4f::Identity();
+    T(0,0) = T(1,1) = 0.6f;
+    T(0,1) = -0.8f;
+    T(1,0) = 0.8f;
+    T(0,3) = 5.0f;
+    T(2,3) = -3.0f;
+    mesh->addTransformMatrix( T);
+    return mesh;
+}   // end makeMesh
+
+
+bool check( bool v, const char *msg)
+{
+    std::cout << (v ? "[PASS] " : "[FAIL] ") << msg << std::endl;
+    return v;
+}   // end check
+
+}   // end namespace
+
+
+int main( int, char**)
+{
+    const Mesh::Ptr mesh = makeMesh( 20);
+    QTemporaryDir tdir;
+    const QString fpath = tdir.filePath( "state.spill");
+    bool ok = true;
+
+    ok &= check( FaceModelState::writeSpill( *mesh, fpath), "Write spill file");
+    const Mesh::Ptr smesh = FaceModelState::readSpill( fpath);
+    ok &= check( smesh != nullptr, "Read spill file");
+    if ( smesh)
+    {
+        ok &= check( smesh->numVtxs() == mesh->numVtxs() && smesh->numFaces() == mesh->numFaces(), "Same counts");
+        ok &= check( smesh->transformMatrix().isApprox( mesh->transformMatrix(), 1e-5f), "Same transform");
+        bool sameVtxs = true;
+        for ( int i = 0; i < int(mesh->numVtxs()); ++i)
+            sameVtxs &= smesh->vtx(i).isApprox( mesh->vtx(i), 1e-4f);
+        ok &= check( sameVtxs, "Same vertices");
+        bool sameFaces = true;
+        for ( int i = 0; i < int(mesh->numFaces()); ++i)
+            for ( int j = 0; j < 3; ++j)
+                sameFaces &= smesh->fvidxs(i)[j] == mesh->fvidxs(i)[j];
+        ok &= check( sameFaces, "Same faces");
+    }   // end if
+
+    const QString bpath = tdir.filePath( "missing/state.spill");
+    ok &= check( !FaceModelState::writeSpill( *mesh, bpath) && !QFile::exists( bpath), "Fail on unwritable path");
+    ok &= check( !FaceModelState::readSpill( bpath), "Fail on missing file");
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}   // end main
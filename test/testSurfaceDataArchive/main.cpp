@@ -0,0 +1,109 @@
+/************************************************************************
+ * Copyright (C) 2021 SIS Research Ltd & Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+
+/**
+ * Round trips named surface data arrays through the archive format checking that names,
+ * values and the content hash are read back as written and that bad data is rejected.
+ */
+
+#include <SurfaceDataArchive.h>
+#include <vtkSmartPointer.h>
+#include <iostream>
+#include <sstream>
+#include <random>
+#include <cstdlib>
+using FaceTools::SurfaceDataArchive;
+
+
+namespace {
+
+vtkSmartPointer<vtkFloatArray> makeArray( const char *name, int ncomps, size_t ntuples, std::mt19937 &rng)
+{
+    std::uniform_real_distribution<float> dist( -10.0f, 10.0f);
+    vtkSmartPointer<vtkFloatArray> arr = vtkSmartPointer<vtkFloatArray>::New();
+    arr->SetName( name);
+    arr->SetNumberOfComponents( ncomps);
+    arr->SetNumberOfTuples( vtkIdType(ntuples));
+    float *vals = arr->GetPointer(0);
+    for ( size_t i = 0; i < ntuples * size_t(ncomps); ++i)
+        vals[i] = dist( rng);
+    return arr;
+}   // end makeArray
+
+
+bool sameArrays( const SurfaceDataArchive::Arrays &a0, const SurfaceDataArchive::Arrays &a1)
+{
+    if ( a0.size() != a1.size())
+        return false;
+    for ( size_t i = 0; i < a0.size(); ++i)
+    {
+        vtkFloatArray *x = a0[i];
+        vtkFloatArray *y = a1[i];
+        if ( std::string( x->GetName()) != std::string( y->GetName())
+                || x->GetNumberOfComponents() != y->GetNumberOfComponents()
+                || x->GetNumberOfTuples() != y->GetNumberOfTuples())
+            return false;
+        const vtkIdType nvals = x->GetNumberOfTuples() * x->GetNumberOfComponents();
+        for ( vtkIdType j = 0; j < nvals; ++j)
+            if ( x->GetPointer(0)[j] != y->GetPointer(0)[j])
+                return false;
+    }   // end for
+    return true;
+}   // end sameArrays
+
+
+bool check( bool v, const char *msg)
+{
+    std::cout << (v ? "[PASS] " : "[FAIL] ") << msg << std::endl;
+    return v;
+}   // end check
+
+}   // end namespace
+
+
+int main( int, char**)
+{
+    static const size_t NTUPLES = 1000;
+    std::mt19937 rng( 7);
+    SurfaceDataArchive::Arrays arrs;
+    arrs.push_back( makeArray( "Curvature", 1, NTUPLES, rng));
+    arrs.push_back( makeArray( "Normals", 3, NTUPLES, rng));
+    const size_t hash = size_t(0x0123456789abcdefull);
+    bool ok = true;
+
+    std::stringstream ss;
+    ok &= check( SurfaceDataArchive::write( arrs, hash, ss), "Write to stream");
+    const std::string bytes = ss.str();
+
+    std::istringstream iss( bytes);
+    SurfaceDataArchive::Arrays rarrs;
+    size_t rhash = 0;
+    ok &= check( SurfaceDataArchive::read( iss, rarrs, rhash, NTUPLES) && rhash == hash && sameArrays( arrs, rarrs),
+                 "Read back from stream");
+
+    std::istringstream nss( bytes);
+    ok &= check( !SurfaceDataArchive::read( nss, rarrs, rhash, NTUPLES+1), "Reject mismatched tuple count");
+
+    std::istringstream tss( bytes.substr( 0, bytes.size() - 4));
+    ok &= check( !SurfaceDataArchive::read( tss, rarrs, rhash, NTUPLES), "Reject truncated data");
+
+    std::istringstream mss( "XXXX" + bytes.substr(4));
+    ok &= check( !SurfaceDataArchive::read( mss, rarrs, rhash, NTUPLES), "Reject bad magic");
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}   // end main
@@ -0,0 +1,176 @@
+/************************************************************************
+ * Copyright (C) 2021 SIS Research Ltd & Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+/**
+ * facebatch: headless detect / extract / measure / export over a directory of models.
+ * Writes a 3DF and a CSV file for each successfully processed model into the output directory.
+ */
+
+#include <FileIO/BatchProcessor.h>
+#include <FileIO/FaceModelXMLFileHandler.h>
+#include <FileIO/FaceModelOBJFileHandler.h>
+#include <FileIO/FaceModelPLYFileHandler.h>
+#include <FileIO/FaceModelSTLFileHandler.h>
+#include <Detect/FeaturesDetector.h>
+#include <LndMrk/LandmarksManager.h>
+#include <Metric/PhenotypeManager.h>
+#include <Metric/MetricManager.h>
+#include <Metric/StatsManager.h>
+#include <MaskRegistration.h>
+#include <Trace.h>
+#include <Ethnicities.h>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <algorithm>
+#include <iostream>
+using namespace FaceTools;
+using FMM = FileIO::FaceModelManager;
+
+
+namespace {
+
+bool loadData( const QCommandLineParser &p, bool detect)
+{
+    if ( p.isSet("ethnicities") && Ethnicities::load( p.value("ethnicities")) <= 0)
+    {
+        std::cerr << "Failed to load ethnicities from " << p.value("ethnicities").toStdString() << std::endl;
+        return false;
+    }   // end if
+
+    if ( Landmark::LandmarksManager::load( p.value("landmarks")) <= 0)
+    {
+        std::cerr << "Failed to load landmarks from " << p.value("landmarks").toStdString() << std::endl;
+        return false;
+    }   // end if
+
+    if ( p.isSet("metrics") && Metric::MetricManager::load( p.value("metrics")) < 0)
+    {
+        std::cerr << "Failed to load metrics from " << p.value("metrics").toStdString() << std::endl;
+        return false;
+    }   // end if
+
+    if ( p.isSet("stats") && Metric::StatsManager::load( p.value("stats")) < 0)
+    {
+        std::cerr << "Failed to load stats from " << p.value("stats").toStdString() << std::endl;
+        return false;
+    }   // end if
+
+    if ( p.isSet("hpos") && Metric::PhenotypeManager::load( p.value("hpos")) < 0)
+    {
+        std::cerr << "Failed to load HPO terms from " << p.value("hpos").toStdString() << std::endl;
+        return false;
+    }   // end if
+
+    if ( detect)
+    {
+        if ( !Detect::FeaturesDetector::initialise( p.value("haar").toStdString()))
+        {
+            std::cerr << "Failed to initialise features detector from " << p.value("haar").toStdString() << std::endl;
+            return false;
+        }   // end if
+
+        if ( !MaskRegistration::setMask( p.value("mask"), false/*load in this thread*/))
+        {
+            std::cerr << "Failed to load mask from " << p.value("mask").toStdString() << std::endl;
+            return false;
+        }   // end if
+    }   // end if
+
+    return true;
+}   // end loadData
+
+}   // end namespace
+
+
+int main( int argc, char **argv)
+{
+    QCoreApplication app( argc, argv);
+    QCoreApplication::setApplicationName("facebatch");
+
+    QCommandLineParser p;
+    p.setApplicationDescription("Detect, extract, measure and export face models without a GUI.");
+    p.addHelpOption();
+    p.addPositionalArgument( "indir", "Directory of models to process.");
+    p.addOptions({
+        {{"o", "outdir"}, "Directory to write processed 3DF and CSV files into.", "dir"},
+        {"mask", "Path to the 3DF correspondence mask.", "3df"},
+        {"haar", "Directory of HaarCascade models for the features detector.", "dir"},
+        {"landmarks", "Landmarks definition file.", "file"},
+        {"ethnicities", "Ethnicities definition file.", "file"},
+        {"metrics", "Directory of metric Lua scripts.", "dir"},
+        {"stats", "Directory of growth data Lua scripts.", "dir"},
+        {"hpos", "Directory of HPO term Lua scripts.", "dir"},
+        {"no-detect", "Use existing masks and landmarks rather than detecting."},
+        {"no-extract", "Don't extract the facial region."},
+        {"no-csv", "Don't write CSV files."},
+        {"threads", "Maximum number of models to process at once (default all available cores).", "n"},
+        {"trace", "Record timings and write them to the given file in Chrome trace format.", "file"}
+    });
+    p.process( app);
+    Trace::setEnabled( p.isSet("trace"));
+
+    const QStringList pargs = p.positionalArguments();
+    const bool detect = !p.isSet("no-detect");
+    if ( pargs.size() != 1 || !p.isSet("outdir") || !p.isSet("landmarks")
+            || (detect && (!p.isSet("mask") || !p.isSet("haar"))))
+    {
+        std::cerr << p.helpText().toStdString() << std::endl;
+        return EXIT_FAILURE;
+    }   // end if
+
+    FMM::add( new FileIO::FaceModelXMLFileHandler); // Preferred
+    FMM::add( new FileIO::FaceModelOBJFileHandler);
+    FMM::add( new FileIO::FaceModelPLYFileHandler);
+    FMM::add( new FileIO::FaceModelSTLFileHandler);
+
+    if ( !loadData( p, detect))
+        return EXIT_FAILURE;
+
+    FileIO::BatchProcessor bproc( p.value("outdir"));
+    if ( !bproc.isValid())
+    {
+        std::cerr << "Cannot write to " << p.value("outdir").toStdString() << std::endl;
+        return EXIT_FAILURE;
+    }   // end if
+    bproc.setDetect( detect);
+    bproc.setExtract( !p.isSet("no-extract"));
+    bproc.setWriteCSV( !p.isSet("no-csv"));
+
+    size_t nfail = 0;
+    const auto results = bproc.processDirectory( pargs.first(),
+            [&nfail]( const FileIO::BatchProcessor::Result &r)
+            {
+                if ( r.err.isEmpty())
+                    std::cout << r.inpath.toStdString() << " -> " << r.outpath.toStdString()
+                              << " (" << r.nhpos << " HPO terms)" << std::endl;
+                else
+                {
+                    std::cerr << r.inpath.toStdString() << ": " << r.err.toStdString() << std::endl;
+                    nfail++;
+                }   // end else
+            }, size_t( std::max( 0, p.value("threads").toInt())));
+
+    std::cout << "Processed " << results.size() - nfail << " of " << results.size() << " models" << std::endl;
+
+    if ( p.isSet("trace") && !Trace::write( p.value("trace")))
+    {
+        std::cerr << "Failed to write trace to " << p.value("trace").toStdString() << std::endl;
+        return EXIT_FAILURE;
+    }   // end if
+
+    return nfail == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}   // end main
@@ -0,0 +1,267 @@
+/************************************************************************
+ * Copyright (C) 2021 SIS Research Ltd & Richard Palmer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ************************************************************************/
+
+/**
+ * facebench: times representative operations on procedurally generated face-like meshes
+ * at several resolutions so that releases can be compared against a baseline.
+ * Mask registration, delta, symmetry and measurement timings require a mask (and landmarks);
+ * measurement timings additionally require the metric definitions.
+ */
+
+#include <FileIO/FaceModelXMLFileHandler.h>
+#include <Action/ActionDetectFace.h>
+#include <Action/ActionUpdateMeasurements.h>
+#include <LndMrk/LandmarksManager.h>
+#include <Metric/MetricManager.h>
+#include <FaceModelCurvatureStore.h>
+#include <FaceModelCurvature.h>
+#include <FaceModelSymmetry.h>
+#include <FaceModelDelta.h>
+#include <MaskRegistration.h>
+#include <Trace.h>
+#include <FaceModel.h>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTemporaryDir>
+#include <functional>
+#include <algorithm>
+#include <limits>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+using namespace FaceTools;
+using FMCS = FaceTools::FaceModelCurvatureStore;
+using LMAN = FaceTools::Landmark::LandmarksManager;
+using MM = FaceTools::Metric::MetricManager;
+
+
+namespace {
+
+/**
+ * Make a face-like height field over a res x res grid clipped to an ellipse. The face is
+ * laterally symmetric about X=0, upright along +Y and looks along +Z. It is scaled to have
+ * the given width and centred at c. Parameter nose varies the prominence of the nose so
+ * that two slightly different faces can be made for the delta timings.
+ */
+r3d::Mesh::Ptr makeFace( int res, float width, const Vec3f &c, float nose=1.0f)
+{
+    r3d::Mesh::Ptr mesh = r3d::Mesh::create();
+    std::vector<int> vidxs( size_t(res*res), -1);
+    const float hw = 0.5f * width;
+    for ( int i = 0; i < res; ++i)
+    {
+        const float y = 1.0f - 2.0f * float(i) / (res - 1);
+        for ( int j = 0; j < res; ++j)
+        {
+            const float x = 2.0f * float(j) / (res - 1) - 1.0f;
+            if ( (x*x)/(0.75f*0.75f) + y*y > 1.0f)
+                continue;
+            const float ex = fabsf(x) - 0.35f;
+            const float ey = y - 0.25f;
+            float z = 0.5f * sqrtf( std::max( 0.0f, 1.0f - (x*x)/0.81f - (y*y)/1.21f));    // Head
+            z += nose * 0.25f * expf( -((x*x)/0.01f + (y+0.05f)*(y+0.05f)/0.06f));          // Nose
+            z -= 0.06f * expf( -(ex*ex + ey*ey)/0.01f);                                      // Orbits
+            z += 0.04f * expf( -((x*x)/0.04f + (y+0.55f)*(y+0.55f)/0.005f));                 // Lips
+            vidxs[size_t(i*res + j)] = mesh->addVertex( c + hw * Vec3f( x, y, z));
+        }   // end for
+    }   // end for
+
+    for ( int i = 0; i < res-1; ++i)
+    {
+        for ( int j = 0; j < res-1; ++j)
+        {
+            const int v0 = vidxs[size_t(i*res + j)];
+            const int v1 = vidxs[size_t(i*res + j + 1)];
+            const int v2 = vidxs[size_t((i+1)*res + j + 1)];
+            const int v3 = vidxs[size_t((i+1)*res + j)];
+            // Counter-clockwise from the front so normals point along +Z
+            if ( v0 >= 0 && v3 >= 0 && v2 >= 0)
+                mesh->addFace( v0, v3, v2);
+            if ( v0 >= 0 && v2 >= 0 && v1 >= 0)
+                mesh->addFace( v0, v2, v1);
+        }   // end for
+    }   // end for
+
+    return mesh;
+}   // end makeFace
+
+
+class Timer
+{
+public:
+    Timer( int res, size_t nvtxs, int iters) : _res(res), _nvtxs(nvtxs), _iters( std::max(1, iters)) {}
+
+    // Time fn over the set number of iterations. If prep is given, it is called
+    // before each iteration and not included in the timing.
+    void operator()( const std::string &name, const std::function<void()> &fn,
+                     const std::function<void()> &prep=nullptr) const
+    {
+        using Clock = std::chrono::steady_clock;
+        double tsum = 0;
+        double tmin = std::numeric_limits<double>::max();
+        for ( int i = 0; i < _iters; ++i)
+        {
+            if ( prep)
+                prep();
+            const Clock::time_point t0 = Clock::now();
+            fn();
+            const double ms = std::chrono::duration<double, std::milli>( Clock::now() - t0).count();
+            tsum += ms;
+            tmin = std::min( tmin, ms);
+        }   // end for
+        std::cout << std::setw(6) << _res << std::setw(10) << _nvtxs << "  " << std::left << std::setw(28) << name
+                  << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(12) << tsum / _iters << std::setw(12) << tmin << std::endl;
+    }   // end operator()
+
+private:
+    const int _res;
+    const size_t _nvtxs;
+    const int _iters;
+};  // end class
+
+
+void benchmark( int res, int iters, bool useMask, bool measure)
+{
+    float width = 150.0f;
+    Vec3f centre = Vec3f::Zero();
+    if ( useMask)
+    {
+        const MaskRegistration::MaskPtr mdata = MaskRegistration::maskData();
+        width = 2.0f * mdata->radius;
+        centre = mdata->centre;
+    }   // end if
+
+    r3d::Mesh::Ptr mesh = makeFace( res, width, centre);
+    FM fm( mesh->deepCopy());
+    const Timer timeit( res, mesh->numVtxs(), iters);
+
+    r3d::Mesh::Ptr umesh;
+    timeit( "FaceModel::update", [&](){ fm.update( umesh, true, true);},
+                                 [&](){ umesh = mesh->deepCopy();});
+
+    timeit( "FaceModelCurvature::create", [&](){ FaceModelCurvature::create( fm.mesh());});
+
+    QTemporaryDir tdir;
+    const QString fpath = tdir.filePath("bench.3df");
+    FileIO::FaceModelXMLFileHandler xmlio;
+    timeit( "3DF write", [&](){ xmlio.write( &fm, fpath);});
+    timeit( "3DF read", [&](){ delete xmlio.read( fpath);});
+
+    if ( !useMask)
+        return;
+
+    // Compare the default coarse-to-fine registration against registering only at full density.
+    r3d::Mesh::Ptr rmask;
+    timeit( "registerMask (full density)", [&](){ rmask = MaskRegistration::registerMask( fm.kdtree(), false);});
+    const float ferr = rmask ? MaskRegistration::registrationError( *rmask, fm.kdtree()) : -1.0f;
+    timeit( "registerMask", [&](){ rmask = MaskRegistration::registerMask( fm.kdtree());});
+    const float merr = rmask ? MaskRegistration::registrationError( *rmask, fm.kdtree()) : -1.0f;
+    std::cout << "        mean registration error (full density / coarse-to-fine): "
+              << ferr << " / " << merr << " " << FM::LENGTH_UNITS.toStdString() << std::endl;
+
+    FMCS::add( fm);
+    if ( !Action::ActionDetectFace::detect( fm, LMAN::ids(), false))
+    {
+        std::cerr << "Mask registration failed at resolution " << res << std::endl;
+        FMCS::purge( fm);
+        return;
+    }   // end if
+
+    FM fm2( makeFace( res, width, centre, 1.2f));
+    FMCS::add( fm2);
+    Action::ActionDetectFace::detect( fm2, LMAN::ids(), false);
+
+    timeit( "FaceModelSymmetry::create", [&](){ FaceModelSymmetry::create( &fm);});
+    if ( fm2.hasMask())
+        timeit( "FaceModelDelta::create", [&](){ FaceModelDelta::create( &fm, &fm2);});
+
+    if ( measure)
+        timeit( "updateAllMeasurements", [&](){ Action::ActionUpdateMeasurements::updateAllMeasurements( &fm);});
+
+    MM::purge( &fm);
+    FMCS::purge( fm2);
+    FMCS::purge( fm);
+}   // end benchmark
+
+}   // end namespace
+
+
+int main( int argc, char **argv)
+{
+    QCoreApplication app( argc, argv);
+    QCoreApplication::setApplicationName("facebench");
+
+    QCommandLineParser p;
+    p.setApplicationDescription("Time core operations on synthetic face meshes.");
+    p.addHelpOption();
+    p.addOptions({
+        {"res", "Comma separated grid resolutions (default 64,128,256).", "list", "64,128,256"},
+        {"iters", "Iterations per timing (default 5).", "n", "5"},
+        {"mask", "Path to the 3DF correspondence mask.", "3df"},
+        {"landmarks", "Landmarks definition file (required with --mask).", "file"},
+        {"metrics", "Directory of metric Lua scripts.", "dir"},
+        {"trace", "Record timings and write them to the given file in Chrome trace format.", "file"}
+    });
+    p.process( app);
+    Trace::setEnabled( p.isSet("trace"));
+
+    const bool useMask = p.isSet("mask");
+    if ( useMask)
+    {
+        if ( !p.isSet("landmarks") || LMAN::load( p.value("landmarks")) <= 0)
+        {
+            std::cerr << "Failed to load landmarks (--landmarks is required with --mask)" << std::endl;
+            return EXIT_FAILURE;
+        }   // end if
+        if ( !MaskRegistration::setMask( p.value("mask"), false/*load in this thread*/))
+        {
+            std::cerr << "Failed to load mask from " << p.value("mask").toStdString() << std::endl;
+            return EXIT_FAILURE;
+        }   // end if
+    }   // end if
+
+    const bool measure = useMask && p.isSet("metrics");
+    if ( measure && MM::load( p.value("metrics")) < 0)
+    {
+        std::cerr << "Failed to load metrics from " << p.value("metrics").toStdString() << std::endl;
+        return EXIT_FAILURE;
+    }   // end if
+
+    const int iters = p.value("iters").toInt();
+    std::cout << std::setw(6) << "res" << std::setw(10) << "vertices" << "  " << std::left << std::setw(28) << "operation"
+              << std::right << std::setw(12) << "mean (ms)" << std::setw(12) << "min (ms)" << std::endl;
+    for ( const QString &rstr : p.value("res").split(',', Qt::SkipEmptyParts))
+    {
+        const int res = rstr.toInt();
+        if ( res < 2)
+        {
+            std::cerr << "Ignoring invalid resolution '" << rstr.toStdString() << "'" << std::endl;
+            continue;
+        }   // end if
+        benchmark( res, iters, useMask, measure);
+    }   // end for
+
+    if ( p.isSet("trace") && !Trace::write( p.value("trace")))
+    {
+        std::cerr << "Failed to write trace to " << p.value("trace").toStdString() << std::endl;
+        return EXIT_FAILURE;
+    }   // end if
+
+    return EXIT_SUCCESS;
+}   // end main